@@ -1,4 +1,4 @@
-import React, { useState, useEffect, useRef } from 'react';
+import React, { useState, useEffect, useRef, useCallback, useMemo, Suspense } from 'react';
 import {
   View,
   Text,
@@ -17,6 +17,8 @@ import {
   Modal,
   Switch,
   Platform,
+  AppState,
+  PixelRatio,
 } from 'react-native';
 import { CameraView, useCameraPermissions } from 'expo-camera';
 import * as ImagePicker from 'expo-image-picker';
@@ -26,29 +28,77 @@ import { NavigationContainer } from '@react-navigation/native';
 import { createStackNavigator } from '@react-navigation/stack';
 import { Picker } from '@react-native-picker/picker';
 import * as FileSystem from 'expo-file-system';
+import * as Crypto from 'expo-crypto';
+import { useVideoPlayer, VideoView } from 'expo-video';
+import * as Network from 'expo-network';
+import * as ImageManipulator from 'expo-image-manipulator';
+import * as SQLite from 'expo-sqlite';
+import Constants from 'expo-constants';
+import pako from 'pako';
 
 const { width, height } = Dimensions.get('window');
 const Stack = createStackNavigator();
 
-// API Configuration
-const API_BASE_URL = 'http://10.53.60.118:3000/api';
+// API Configuration (the web admin console is served by the API server itself)
+const API_BASE_URL = Platform.OS === 'web' ? '/api' : 'http://10.53.60.118:3000/api';
+
+// Conditional GET cache: last ETag and body per endpoint, revalidated with If-None-Match
+const etagCache = new Map();
+
+// Rolling connection estimate from apiCall timings (server time from Server-Timing taken out):
+// small requests track the round trip, requests carrying enough bytes track throughput
+const NETWORK_EWMA_WEIGHT = 0.3;
+const NETWORK_RTT_MAX_BYTES = 2 * 1024;
+const NETWORK_THROUGHPUT_MIN_BYTES = 32 * 1024;
+const networkEstimate = { rttMs: 300, bytesPerMs: 60, rttSamples: 0, throughputSamples: 0 };
+
+const recordNetworkTiming = (bytes, elapsedMs, response) => {
+  const serverTiming = /dur=([\d.]+)/.exec(response.headers.get('Server-Timing') || '');
+  const networkMs = Math.max(elapsedMs - (serverTiming ? Number(serverTiming[1]) : 0), 1);
+  const blend = (current, sample, samples) =>
+    samples === 0 ? sample : current + NETWORK_EWMA_WEIGHT * (sample - current);
+
+  if (bytes <= NETWORK_RTT_MAX_BYTES) {
+    networkEstimate.rttMs = blend(networkEstimate.rttMs, networkMs, networkEstimate.rttSamples++);
+  } else if (bytes >= NETWORK_THROUGHPUT_MIN_BYTES) {
+    const transferMs = Math.max(networkMs - networkEstimate.rttMs, 1);
+    networkEstimate.bytesPerMs = blend(networkEstimate.bytesPerMs, bytes / transferMs, networkEstimate.throughputSamples++);
+  }
+};
 
 // Enhanced API Helper Functions
 const apiCall = async (endpoint, options = {}) => {
   try {
     const token = await AsyncStorage.getItem('userToken');
+    const isGet = !options.method || options.method === 'GET';
+    const cached = isGet ? etagCache.get(endpoint) : null;
     const headers = {
       'Content-Type': 'application/json',
       ...(token && { 'Authorization': `Bearer ${token}` }),
+      ...(cached && { 'If-None-Match': cached.etag }),
       ...options.headers,
     };
 
+    const requestBytes = typeof options.body === 'string' ? options.body.length : options.body?.byteLength || 0;
+    const startedAt = Date.now();
     const response = await fetch(`${API_BASE_URL}${endpoint}`, {
       ...options,
       headers,
     });
 
+    if (response.status === 304 && cached) {
+      recordNetworkTiming(requestBytes, Date.now() - startedAt, response);
+      return cached.data;
+    }
+
     const data = await response.json();
+    const responseBytes = Number(response.headers.get('Content-Length')) || 0;
+    recordNetworkTiming(requestBytes + responseBytes, Date.now() - startedAt, response);
+
+    const etag = response.headers.get('ETag');
+    if (isGet && response.ok && etag) {
+      etagCache.set(endpoint, { etag, data });
+    }
 
     if (!response.ok) {
       throw new Error(data.error || data.message || `HTTP ${response.status}`);
@@ -63,6 +113,730 @@ const apiCall = async (endpoint, options = {}) => {
   }
 };
 
+// Performance telemetry: marks along a user flow are kept in a ring buffer (oldest overwritten)
+// and uploaded gzip-compressed in batches; the server aggregates them per app version
+const PERF_BUFFER_SIZE = 500;
+const PERF_BATCH_SIZE = 100;
+const PERF_FLUSH_INTERVAL = 60 * 1000;
+const APP_VERSION = Constants.expoConfig?.version || '0.0.0';
+
+const perfBuffer = new Array(PERF_BUFFER_SIZE);
+let perfHead = 0;
+let perfCount = 0;
+let perfFlushing = false;
+
+const pushPerfSample = (sample) => {
+  perfBuffer[perfHead] = sample;
+  perfHead = (perfHead + 1) % PERF_BUFFER_SIZE;
+  perfCount = Math.min(perfCount + 1, PERF_BUFFER_SIZE);
+};
+
+const drainPerfSamples = () => {
+  const start = (perfHead - perfCount + PERF_BUFFER_SIZE) % PERF_BUFFER_SIZE;
+  const samples = [];
+  for (let i = 0; i < perfCount; i++) {
+    samples.push(perfBuffer[(start + i) % PERF_BUFFER_SIZE]);
+  }
+  perfCount = 0;
+  return samples;
+};
+
+const flushPerfSamples = async () => {
+  if (perfFlushing || perfCount === 0) return;
+  perfFlushing = true;
+  const samples = drainPerfSamples();
+  try {
+    const token = await AsyncStorage.getItem('userToken');
+    if (!token) throw new Error('Not signed in');
+    await apiCall('/telemetry/perf', {
+      method: 'POST',
+      headers: { 'Content-Encoding': 'gzip' },
+      body: pako.gzip(JSON.stringify({ appVersion: APP_VERSION, platform: Platform.OS, samples })),
+    });
+  } catch (error) {
+    // Keep them for the next flush; anything recorded meanwhile is newer and wins if the ring is full
+    const recent = drainPerfSamples();
+    [...samples, ...recent].forEach(pushPerfSample);
+  } finally {
+    perfFlushing = false;
+  }
+};
+
+// Start timing a flow; each mark (recorded once) is the time in ms since the flow started.
+// On web, performance.now() counts from navigation start, so `startedAt = 0` times a cold load
+const startPerfFlow = (flow, startedAt = performance.now()) => {
+  const marked = new Set();
+  return {
+    mark: (name) => {
+      if (marked.has(name)) return;
+      marked.add(name);
+      pushPerfSample([flow, name, Math.round(performance.now() - startedAt)]);
+      if (perfCount >= PERF_BATCH_SIZE) flushPerfSamples();
+    },
+  };
+};
+
+setInterval(flushPerfSamples, PERF_FLUSH_INTERVAL);
+AppState.addEventListener('change', (state) => {
+  if (state === 'background') flushPerfSamples();
+});
+
+// Face capture tiers, best first: each upload uses the first tier whose predicted upload time
+// (round trip plus base64 size over the estimated throughput) fits the target
+const CAPTURE_TARGET_UPLOAD_MS = 3000;
+const CAPTURE_TIERS = [
+  { name: 'high', width: 1080, compress: 0.8, bytes: 300 * 1024 },
+  { name: 'medium', width: 720, compress: 0.7, bytes: 130 * 1024 },
+  { name: 'low', width: 480, compress: 0.6, bytes: 60 * 1024 },
+  { name: 'minimal', width: 320, compress: 0.5, bytes: 28 * 1024 },
+];
+// Last base64 size seen per tier, which replaces the starting guess above
+const captureTierBytes = new Map();
+
+const selectCaptureTier = (lowestTier) => {
+  const lowestIndex = CAPTURE_TIERS.findIndex(tier => tier.name === lowestTier);
+  const candidates = lowestIndex === -1 ? CAPTURE_TIERS : CAPTURE_TIERS.slice(0, lowestIndex + 1);
+  const predictMs = (tier) =>
+    networkEstimate.rttMs + (captureTierBytes.get(tier.name) || tier.bytes) / networkEstimate.bytesPerMs;
+  return candidates.find(tier => predictMs(tier) <= CAPTURE_TARGET_UPLOAD_MS) || candidates[candidates.length - 1];
+};
+
+// Resize and recompress a captured photo for the current connection (never upscaling)
+const prepareCaptureUpload = async (asset, lowestTier) => {
+  const tier = selectCaptureTier(lowestTier);
+  const actions = asset.width > tier.width ? [{ resize: { width: tier.width } }] : [];
+  const image = await ImageManipulator.manipulateAsync(asset.uri, actions, {
+    compress: tier.compress,
+    format: ImageManipulator.SaveFormat.JPEG,
+    base64: true,
+  });
+  captureTierBytes.set(tier.name, image.base64.length);
+  return { imageBase64: image.base64, captureTier: tier.name };
+};
+
+// Local replica (SQLite) of attendance history, materials, notifications and courses. Screens
+// read indexed local rows first, then apply server responses as upserts in one transaction.
+const LOCAL_DB_NAME = 'replica.db';
+const LOCAL_DB_VERSION = 1;
+let localDbPromise = null;
+
+const LOCAL_DB_SCHEMA = `
+  PRAGMA journal_mode = WAL;
+  CREATE TABLE IF NOT EXISTS attendance (
+    id TEXT PRIMARY KEY NOT NULL,
+    course_code TEXT NOT NULL,
+    date TEXT NOT NULL,
+    status TEXT NOT NULL,
+    timestamp INTEGER NOT NULL,
+    data TEXT NOT NULL
+  );
+  CREATE INDEX IF NOT EXISTS attendance_timestamp ON attendance (timestamp DESC);
+  CREATE INDEX IF NOT EXISTS attendance_status_timestamp ON attendance (status, timestamp DESC);
+  CREATE INDEX IF NOT EXISTS attendance_course_date ON attendance (course_code, date);
+  CREATE TABLE IF NOT EXISTS materials (
+    id TEXT PRIMARY KEY NOT NULL,
+    course_code TEXT NOT NULL,
+    created_at INTEGER NOT NULL,
+    data TEXT NOT NULL
+  );
+  CREATE INDEX IF NOT EXISTS materials_created ON materials (created_at DESC);
+  CREATE INDEX IF NOT EXISTS materials_course_created ON materials (course_code, created_at DESC);
+  CREATE TABLE IF NOT EXISTS notifications (
+    id TEXT PRIMARY KEY NOT NULL,
+    is_read INTEGER NOT NULL,
+    created_at INTEGER NOT NULL,
+    data TEXT NOT NULL
+  );
+  CREATE INDEX IF NOT EXISTS notifications_created ON notifications (created_at DESC);
+  CREATE TABLE IF NOT EXISTS courses (
+    course_code TEXT PRIMARY KEY NOT NULL,
+    data TEXT NOT NULL
+  );
+  CREATE TABLE IF NOT EXISTS sync_state (
+    resource TEXT PRIMARY KEY NOT NULL,
+    cursor TEXT NOT NULL
+  );
+`;
+
+// Indexed columns per table; the full record is kept as JSON in `data`
+const LOCAL_TABLES = {
+  attendance: {
+    columns: ['id', 'course_code', 'date', 'status', 'timestamp', 'data'],
+    row: (record) => [record._id, record.courseCode, record.date, record.status, new Date(record.timestamp).getTime(), JSON.stringify(record)],
+  },
+  materials: {
+    columns: ['id', 'course_code', 'created_at', 'data'],
+    row: (material) => [material._id, material.courseCode, new Date(material.createdAt).getTime(), JSON.stringify(material)],
+  },
+  notifications: {
+    columns: ['id', 'is_read', 'created_at', 'data'],
+    row: (notification) => [notification._id, notification.isRead ? 1 : 0, new Date(notification.createdAt).getTime(), JSON.stringify(notification)],
+  },
+  courses: {
+    columns: ['course_code', 'data'],
+    row: (course) => [course.courseCode, JSON.stringify(course)],
+  },
+};
+
+const openLocalDb = () => {
+  if (!localDbPromise) {
+    localDbPromise = (async () => {
+      const db = await SQLite.openDatabaseAsync(LOCAL_DB_NAME);
+      const { user_version: version } = await db.getFirstAsync('PRAGMA user_version');
+      if (version < LOCAL_DB_VERSION) {
+        await db.execAsync(`${LOCAL_DB_SCHEMA} PRAGMA user_version = ${LOCAL_DB_VERSION};`);
+      }
+      return db;
+    })();
+    localDbPromise.catch(() => {
+      localDbPromise = null;
+    });
+  }
+  return localDbPromise;
+};
+
+// Upsert records; `replace` marks a complete server list, so rows missing from it are removed
+const upsertLocalRows = async (table, records, { replace = false } = {}) => {
+  const db = await openLocalDb();
+  const { columns, row } = LOCAL_TABLES[table];
+  await db.withTransactionAsync(async () => {
+    if (replace) {
+      await db.runAsync(`DELETE FROM ${table}`);
+    }
+    const statement = await db.prepareAsync(
+      `INSERT OR REPLACE INTO ${table} (${columns.join(', ')}) VALUES (${columns.map(() => '?').join(', ')})`
+    );
+    try {
+      for (const record of records) {
+        await statement.executeAsync(row(record));
+      }
+    } finally {
+      await statement.finalizeAsync();
+    }
+  });
+};
+
+const queryLocalRows = async (sql, params = []) => {
+  const db = await openLocalDb();
+  const rows = await db.getAllAsync(sql, params);
+  return rows.map(row => JSON.parse(row.data));
+};
+
+const queryLocalAttendance = (status) => (status === 'all'
+  ? queryLocalRows('SELECT data FROM attendance ORDER BY timestamp DESC')
+  : queryLocalRows('SELECT data FROM attendance WHERE status = ? ORDER BY timestamp DESC', [status]));
+
+// Pull attendance records added since the stored cursor, page by page
+const syncAttendanceHistory = async () => {
+  const db = await openLocalDb();
+  const state = await db.getFirstAsync('SELECT cursor FROM sync_state WHERE resource = ?', ['attendance']);
+  let cursor = state?.cursor || '';
+
+  for (;;) {
+    const response = await apiCall(`/student/attendance/sync?after=${cursor}`);
+    const { records, cursor: nextCursor, hasMore } = response.data;
+    await upsertLocalRows('attendance', records);
+    await db.runAsync('INSERT OR REPLACE INTO sync_state (resource, cursor) VALUES (?, ?)', ['attendance', nextCursor]);
+    if (!hasMore || nextCursor === cursor) break;
+    cursor = nextCursor;
+  }
+};
+
+// The replica holds the signed-in user's data, so it goes with the session
+const clearLocalStore = async () => {
+  const db = await openLocalDb();
+  await db.execAsync(
+    [...Object.keys(LOCAL_TABLES), 'sync_state'].map(table => `DELETE FROM ${table};`).join(' ')
+  );
+};
+
+// Resumable chunked material uploads: fixed-size chunks with a CRC32 each, sent in parallel
+// and resumed from the server's list of received chunks (keyed by file uri and size)
+const UPLOAD_CONCURRENCY = 3;
+const UPLOAD_CHUNK_RETRIES = 3;
+
+const CRC32_TABLE = (() => {
+  const table = new Int32Array(256);
+  for (let n = 0; n < 256; n++) {
+    let c = n;
+    for (let k = 0; k < 8; k++) {
+      c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+    }
+    table[n] = c;
+  }
+  return table;
+})();
+
+// CRC32 of a binary string (one byte per char, as returned by atob)
+const crc32 = (binary) => {
+  let crc = -1;
+  for (let i = 0; i < binary.length; i++) {
+    crc = CRC32_TABLE[(crc ^ binary.charCodeAt(i)) & 0xff] ^ (crc >>> 8);
+  }
+  return ((crc ^ -1) >>> 0).toString(16).padStart(8, '0');
+};
+
+// PUT a chunk, retrying with exponential backoff
+const sendChunkWithRetry = async (endpoint, headers, body) => {
+  for (let attempt = 1; ; attempt++) {
+    try {
+      return await apiCall(endpoint, { method: 'PUT', headers, body });
+    } catch (error) {
+      if (attempt >= UPLOAD_CHUNK_RETRIES) throw error;
+      await new Promise(resolve => setTimeout(resolve, 500 * 2 ** attempt));
+    }
+  }
+};
+
+// Drain a queue with a fixed number of parallel workers
+const runUploadQueue = async (queue, worker) => {
+  const workers = Array.from({ length: Math.min(UPLOAD_CONCURRENCY, queue.length) }, async () => {
+    while (queue.length > 0) {
+      await worker(queue.shift());
+    }
+  });
+  await Promise.all(workers);
+};
+
+const uploadMaterialFile = async (file, metadata, onProgress) => {
+  const resumeKey = `upload:${file.uri}:${file.size}`;
+  let status = null;
+
+  const savedUploadId = await AsyncStorage.getItem(resumeKey);
+  if (savedUploadId) {
+    try {
+      const response = await apiCall(`/admin/materials/uploads/${savedUploadId}`);
+      status = response.data;
+    } catch (error) {
+      await AsyncStorage.removeItem(resumeKey);
+    }
+  }
+
+  if (!status) {
+    const response = await apiCall('/admin/materials/uploads', {
+      method: 'POST',
+      body: JSON.stringify({
+        ...metadata,
+        fileName: file.name,
+        fileSize: file.size,
+        mimeType: file.mimeType,
+      }),
+    });
+    status = response.data;
+    await AsyncStorage.setItem(resumeKey, status.uploadId);
+  }
+
+  const received = new Set(status.receivedChunks);
+  const pending = [];
+  for (let index = 0; index < status.totalChunks; index++) {
+    if (!received.has(index)) pending.push(index);
+  }
+  let completed = received.size;
+  onProgress?.(completed / status.totalChunks);
+
+  const sendChunk = async (index) => {
+    const position = index * status.chunkSize;
+    const length = Math.min(status.chunkSize, status.fileSize - position);
+    const base64 = await FileSystem.readAsStringAsync(file.uri, {
+      encoding: FileSystem.EncodingType.Base64,
+      position,
+      length,
+    });
+    await sendChunkWithRetry(`/admin/materials/uploads/${status.uploadId}/chunks/${index}`, {
+      'Content-Type': 'text/plain',
+      'X-Chunk-Checksum': crc32(atob(base64)),
+      'X-Chunk-Encoding': 'base64',
+    }, base64);
+    completed++;
+    onProgress?.(completed / status.totalChunks);
+  };
+
+  await runUploadQueue(pending, sendChunk);
+
+  const response = await apiCall(`/admin/materials/uploads/${status.uploadId}/complete`, {
+    method: 'POST',
+  });
+  await AsyncStorage.removeItem(resumeKey);
+  return response;
+};
+
+// Content-defined chunking for material revisions. The gear table and cut points must match the
+// server's chunk store exactly, so unchanged parts of a revised file hash to chunks it already has.
+const CDC_MIN_SIZE = 8 * 1024;
+const CDC_AVG_SIZE = 32 * 1024;
+const CDC_MAX_SIZE = 128 * 1024;
+const CDC_MASK_SMALL = 0xffff8000 | 0;
+const CDC_MASK_LARGE = 0xfff80000 | 0;
+const CDC_READ_WINDOW = 1024 * 1024;
+
+const CDC_GEAR = (() => {
+  const table = new Int32Array(256);
+  let seed = 0x9e3779b9;
+  for (let i = 0; i < 256; i++) {
+    seed = (seed + 0x6d2b79f5) | 0;
+    let t = Math.imul(seed ^ (seed >>> 15), seed | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    table[i] = t ^ (t >>> 14);
+  }
+  return table;
+})();
+
+const cdcCut = (bytes, start, end) => {
+  const available = end - start;
+  if (available <= CDC_MIN_SIZE) return available;
+  const normal = Math.min(available, CDC_AVG_SIZE);
+  const limit = Math.min(available, CDC_MAX_SIZE);
+  let hash = 0;
+  let i = CDC_MIN_SIZE;
+  for (; i < normal; i++) {
+    hash = ((hash << 1) + CDC_GEAR[bytes[start + i]]) | 0;
+    if ((hash & CDC_MASK_SMALL) === 0) return i + 1;
+  }
+  for (; i < limit; i++) {
+    hash = ((hash << 1) + CDC_GEAR[bytes[start + i]]) | 0;
+    if ((hash & CDC_MASK_LARGE) === 0) return i + 1;
+  }
+  return limit;
+};
+
+const base64ToBytes = (base64) => {
+  const binary = atob(base64);
+  const bytes = new Uint8Array(binary.length);
+  for (let i = 0; i < binary.length; i++) {
+    bytes[i] = binary.charCodeAt(i);
+  }
+  return bytes;
+};
+
+const bytesToHex = (buffer) => Array.from(new Uint8Array(buffer), byte => byte.toString(16).padStart(2, '0')).join('');
+
+// Split a local file into { hash, size, offset } chunks, reading it a window at a time
+const chunkFileByContent = async (file) => {
+  const chunks = [];
+  const addChunk = async (bytes, offset) => {
+    const digest = await Crypto.digest(Crypto.CryptoDigestAlgorithm.SHA256, bytes);
+    chunks.push({ hash: bytesToHex(digest), size: bytes.length, offset });
+  };
+
+  let pending = new Uint8Array(0);
+  let pendingOffset = 0;
+  for (let position = 0; position < file.size; position += CDC_READ_WINDOW) {
+    const data = base64ToBytes(await FileSystem.readAsStringAsync(file.uri, {
+      encoding: FileSystem.EncodingType.Base64,
+      position,
+      length: Math.min(CDC_READ_WINDOW, file.size - position),
+    }));
+    const merged = new Uint8Array(pending.length + data.length);
+    merged.set(pending);
+    merged.set(data, pending.length);
+
+    let start = 0;
+    while (merged.length - start >= CDC_MAX_SIZE) {
+      const length = cdcCut(merged, start, merged.length);
+      await addChunk(merged.slice(start, start + length), pendingOffset + start);
+      start += length;
+    }
+    pending = merged.slice(start);
+    pendingOffset += start;
+  }
+  while (pending.length > 0) {
+    const length = cdcCut(pending, 0, pending.length);
+    await addChunk(pending.slice(0, length), pendingOffset);
+    pending = pending.slice(length);
+    pendingOffset += length;
+  }
+  return chunks;
+};
+
+// Upload a new version of an existing material, sending only the chunks the server lacks.
+// Interrupted uploads resume naturally: chunks already stored no longer show up as missing.
+const uploadMaterialRevision = async (materialId, file, onProgress) => {
+  const chunks = await chunkFileByContent(file);
+  const missingResponse = await apiCall('/admin/materials/chunks/missing', {
+    method: 'POST',
+    body: JSON.stringify({ hashes: chunks.map(chunk => chunk.hash) }),
+  });
+
+  const missing = new Set(missingResponse.data.missing);
+  const pending = chunks.filter(chunk => missing.delete(chunk.hash));
+  const transferBytes = pending.reduce((total, chunk) => total + chunk.size, 0);
+  let sentBytes = 0;
+  onProgress?.(transferBytes === 0 ? 1 : 0);
+
+  await runUploadQueue(pending, async (chunk) => {
+    const base64 = await FileSystem.readAsStringAsync(file.uri, {
+      encoding: FileSystem.EncodingType.Base64,
+      position: chunk.offset,
+      length: chunk.size,
+    });
+    await sendChunkWithRetry(`/admin/materials/chunks/${chunk.hash}`, {
+      'Content-Type': 'text/plain',
+      'X-Chunk-Encoding': 'base64',
+    }, base64);
+    sentBytes += chunk.size;
+    onProgress?.(sentBytes / transferBytes);
+  });
+
+  const response = await apiCall(`/admin/materials/${materialId}/revisions`, {
+    method: 'POST',
+    body: JSON.stringify({
+      fileName: file.name,
+      mimeType: file.mimeType,
+      chunks: chunks.map(({ hash, size }) => ({ hash, size })),
+    }),
+  });
+  return { ...response, transferBytes };
+};
+
+// Offline material cache. Files are stored under documentDirectory/materials keyed by content hash,
+// tracked in an LRU index in AsyncStorage and evicted oldest-first beyond the storage budget.
+// Interrupted downloads keep their resume data and continue with a Range request next time.
+const MATERIAL_CACHE_DIR = `${FileSystem.documentDirectory}materials/`;
+const MATERIAL_CACHE_INDEX_KEY = 'materialCache:index';
+const MATERIAL_CACHE_BUDGET = 200 * 1024 * 1024;
+const MATERIAL_PREFETCH_DAYS = 7;
+const MATERIAL_PREFETCH_MAX_SIZE = 20 * 1024 * 1024;
+
+let materialCacheIndex = null;
+const activeMaterialDownloads = new Map();
+
+const loadMaterialCacheIndex = async () => {
+  if (!materialCacheIndex) {
+    const stored = await AsyncStorage.getItem(MATERIAL_CACHE_INDEX_KEY);
+    materialCacheIndex = stored ? JSON.parse(stored) : { entries: {}, resumable: {} };
+    await FileSystem.makeDirectoryAsync(MATERIAL_CACHE_DIR, { intermediates: true }).catch(() => {});
+  }
+  return materialCacheIndex;
+};
+
+const saveMaterialCacheIndex = () =>
+  AsyncStorage.setItem(MATERIAL_CACHE_INDEX_KEY, JSON.stringify(materialCacheIndex));
+
+// Legacy uploads have no content hash; they are keyed by id and revalidated with the server's ETag
+const materialCacheKey = (material) => material.fileHash || `material-${material._id}`;
+
+const isMaterialCached = (material) => Boolean(materialCacheIndex?.entries[materialCacheKey(material)]);
+
+const evictMaterialCache = async (keepKey) => {
+  const entries = materialCacheIndex.entries;
+  let total = Object.values(entries).reduce((sum, entry) => sum + entry.size, 0);
+  const oldestFirst = Object.keys(entries)
+    .filter(key => key !== keepKey)
+    .sort((a, b) => entries[a].lastUsed - entries[b].lastUsed);
+
+  for (const key of oldestFirst) {
+    if (total <= MATERIAL_CACHE_BUDGET) break;
+    await FileSystem.deleteAsync(entries[key].uri, { idempotent: true });
+    total -= entries[key].size;
+    delete entries[key];
+  }
+};
+
+// Return a local copy of a material, downloading it only if the cached copy is missing or stale
+const getOfflineMaterial = (material, { prefetch = false, onProgress } = {}) => {
+  if (activeMaterialDownloads.has(material._id)) {
+    return activeMaterialDownloads.get(material._id).promise;
+  }
+
+  const entry = { download: null, key: materialCacheKey(material) };
+  entry.promise = (async () => {
+    const index = await loadMaterialCacheIndex();
+    const cached = index.entries[entry.key];
+    if (cached && material.fileHash) {
+      const info = await FileSystem.getInfoAsync(cached.uri);
+      if (info.exists) {
+        cached.lastUsed = Date.now();
+        await saveMaterialCacheIndex();
+        return { uri: cached.uri, transferred: false };
+      }
+    }
+
+    const token = await AsyncStorage.getItem('userToken');
+    const headers = {
+      Authorization: `Bearer ${token}`,
+      ...(cached?.etag && { 'If-None-Match': cached.etag }),
+    };
+    const url = `${API_BASE_URL}/materials/download/${material._id}${prefetch ? '?prefetch=1' : ''}`;
+    const extension = (material.fileName?.match(/\.\w+$/) || [''])[0];
+    const fileUri = `${MATERIAL_CACHE_DIR}${entry.key}${extension}`;
+    const partialUri = `${fileUri}.download`;
+    const reportProgress = ({ totalBytesWritten, totalBytesExpectedToWrite }) => {
+      if (totalBytesExpectedToWrite > 0) onProgress?.(totalBytesWritten / totalBytesExpectedToWrite);
+    };
+
+    const saved = index.resumable[material._id];
+    entry.download = saved?.key === entry.key
+      ? FileSystem.createDownloadResumable(url, partialUri, { headers }, reportProgress, saved.resumeData)
+      : FileSystem.createDownloadResumable(url, partialUri, { headers }, reportProgress);
+
+    let result;
+    try {
+      result = saved?.key === entry.key ? await entry.download.resumeAsync() : await entry.download.downloadAsync();
+    } catch (error) {
+      await pauseMaterialDownload(material._id, entry);
+      throw error;
+    }
+    // downloadAsync resolves undefined when the download was paused (app sent to background)
+    if (!result) throw new Error('Download paused');
+
+    delete index.resumable[material._id];
+    if (result.status === 304 && cached) {
+      await FileSystem.deleteAsync(partialUri, { idempotent: true });
+      cached.lastUsed = Date.now();
+      await saveMaterialCacheIndex();
+      return { uri: cached.uri, transferred: false };
+    }
+    if (result.status !== 200 && result.status !== 206) {
+      await FileSystem.deleteAsync(partialUri, { idempotent: true });
+      await saveMaterialCacheIndex();
+      throw new Error(`Download failed (HTTP ${result.status})`);
+    }
+
+    await FileSystem.deleteAsync(fileUri, { idempotent: true });
+    await FileSystem.moveAsync({ from: partialUri, to: fileUri });
+    const info = await FileSystem.getInfoAsync(fileUri, { size: true });
+    index.entries[entry.key] = {
+      uri: fileUri,
+      size: info.size || 0,
+      lastUsed: Date.now(),
+      etag: result.headers?.ETag || result.headers?.etag || null,
+    };
+    await evictMaterialCache(entry.key);
+    await saveMaterialCacheIndex();
+    return { uri: fileUri, transferred: true };
+  })().finally(() => activeMaterialDownloads.delete(material._id));
+
+  activeMaterialDownloads.set(material._id, entry);
+  return entry.promise;
+};
+
+// Offline copies belong to the signed-in student's courses, so they go with the session
+const clearMaterialCache = async () => {
+  materialCacheIndex = null;
+  await AsyncStorage.removeItem(MATERIAL_CACHE_INDEX_KEY);
+  await FileSystem.deleteAsync(MATERIAL_CACHE_DIR, { idempotent: true });
+};
+
+// Keep resume data for an interrupted download so the next attempt continues where it stopped
+const pauseMaterialDownload = async (materialId, entry) => {
+  try {
+    const paused = await entry.download?.pauseAsync();
+    if (paused?.resumeData) {
+      const index = await loadMaterialCacheIndex();
+      index.resumable[materialId] = { key: entry.key, resumeData: paused.resumeData };
+      await saveMaterialCacheIndex();
+    }
+  } catch (error) {
+    // The transfer had already ended; it will restart from the beginning
+  }
+};
+
+AppState.addEventListener('change', (state) => {
+  if (state === 'background') {
+    activeMaterialDownloads.forEach((entry, materialId) => pauseMaterialDownload(materialId, entry));
+  }
+});
+
+// Quietly fetch recently published materials while on Wi-Fi so they open offline later
+const prefetchNewMaterials = async (materials) => {
+  try {
+    const network = await Network.getNetworkStateAsync();
+    if (network.type !== Network.NetworkStateType.WIFI || !network.isInternetReachable) return false;
+
+    await loadMaterialCacheIndex();
+    const since = Date.now() - MATERIAL_PREFETCH_DAYS * 24 * 60 * 60 * 1000;
+    const candidates = materials.filter(material =>
+      material.fileName &&
+      material.materialType !== 'video' &&
+      (material.fileSize || 0) <= MATERIAL_PREFETCH_MAX_SIZE &&
+      new Date(material.publishDate || material.createdAt).getTime() >= since &&
+      !isMaterialCached(material)
+    );
+
+    for (const material of candidates) {
+      await getOfflineMaterial(material, { prefetch: true }).catch(error =>
+        console.log('Prefetch skipped:', material._id, error.message)
+      );
+    }
+    return candidates.length > 0;
+  } catch (error) {
+    console.log('Material prefetch failed:', error.message);
+    return false;
+  }
+};
+
+// Image cache: variants are requested at the rendered pixel size (the server snaps to fixed sizes),
+// kept on disk under cacheDirectory/images and remembered in a small in-memory LRU so list rows
+// that scroll back into view render from a local file without waiting on AsyncStorage or the network.
+const IMAGE_CACHE_DIR = `${FileSystem.cacheDirectory}images/`;
+const IMAGE_MEMORY_CACHE_SIZE = 150;
+const imageMemoryCache = new Map();
+const pendingImageDownloads = new Map();
+
+const imageCacheKey = (path, pixelSize) => `${path}@${pixelSize}`;
+
+const rememberImage = (key, uri) => {
+  imageMemoryCache.delete(key);
+  imageMemoryCache.set(key, uri);
+  if (imageMemoryCache.size > IMAGE_MEMORY_CACHE_SIZE) {
+    imageMemoryCache.delete(imageMemoryCache.keys().next().value);
+  }
+};
+
+const getCachedImageUri = (path, pixelSize) => {
+  const key = imageCacheKey(path, pixelSize);
+  if (pendingImageDownloads.has(key)) return pendingImageDownloads.get(key);
+
+  const task = (async () => {
+    const fileName = await Crypto.digestStringAsync(Crypto.CryptoDigestAlgorithm.SHA1, key);
+    const fileUri = `${IMAGE_CACHE_DIR}${fileName}.jpg`;
+    const info = await FileSystem.getInfoAsync(fileUri);
+    if (!info.exists) {
+      await FileSystem.makeDirectoryAsync(IMAGE_CACHE_DIR, { intermediates: true }).catch(() => {});
+      const token = await AsyncStorage.getItem('userToken');
+      const result = await FileSystem.downloadAsync(`${API_BASE_URL}${path}?size=${pixelSize}`, fileUri, {
+        headers: { Authorization: `Bearer ${token}` },
+      });
+      if (result.status !== 200) {
+        await FileSystem.deleteAsync(fileUri, { idempotent: true });
+        throw new Error(`Image request failed (HTTP ${result.status})`);
+      }
+    }
+    rememberImage(key, fileUri);
+    return fileUri;
+  })().finally(() => pendingImageDownloads.delete(key));
+
+  pendingImageDownloads.set(key, task);
+  return task;
+};
+
+const clearImageCache = async () => {
+  imageMemoryCache.clear();
+  await FileSystem.deleteAsync(IMAGE_CACHE_DIR, { idempotent: true });
+};
+
+// Image from the variant endpoints at `size` layout points; `path` must carry the content version
+const CachedImage = ({ path, size, style, placeholder = null }) => {
+  const pixelSize = PixelRatio.getPixelSizeForLayoutSize(size);
+  const key = imageCacheKey(path, pixelSize);
+  const [uri, setUri] = useState(() => imageMemoryCache.get(key) || null);
+
+  useEffect(() => {
+    let cancelled = false;
+    const cached = imageMemoryCache.get(key);
+    setUri(cached || null);
+    if (path && !cached) {
+      getCachedImageUri(path, pixelSize)
+        .then(fileUri => { if (!cancelled) setUri(fileUri); })
+        .catch(error => console.log('Image load failed:', path, error.message));
+    }
+    return () => { cancelled = true; };
+  }, [key]);
+
+  if (!path || !uri) return placeholder;
+  return <Image source={{ uri }} style={[{ width: size, height: size }, style]} />;
+};
+
 // Utility functions
 const showSuccess = (message) => Alert.alert('Success', message);
 const showError = (message) => Alert.alert('Error', message);
@@ -104,6 +878,16 @@ const parseDateString = (value) => {
   }
 };
 
+// List helpers: rows are memoized components fed stable props, and fixed-height rows
+// let FlatList compute offsets instead of measuring every row
+const EMPTY_LIST = [];
+const keyById = (item) => item._id;
+const fixedRowLayout = (rowHeight) => (data, index) => ({ length: rowHeight, offset: rowHeight * index, index });
+const STUDENT_ROW_HEIGHT = 96;
+const HISTORY_ROW_HEIGHT = 72;
+const getStudentRowLayout = fixedRowLayout(STUDENT_ROW_HEIGHT);
+const getHistoryRowLayout = fixedRowLayout(HISTORY_ROW_HEIGHT);
+
 // Professional Loading Screen
 const LoadingScreen = ({ message = 'Loading...' }) => (
   <SafeAreaView style={styles.container}>
@@ -852,6 +1636,10 @@ const AdminDashboardScreen = ({ navigation }) => {
           style: 'destructive',
           onPress: async () => {
             await AsyncStorage.multiRemove(['userToken', 'userRole', 'userInfo']);
+            etagCache.clear();
+            await clearLocalStore();
+            await clearMaterialCache();
+            await clearImageCache();
             navigation.replace('Login');
           }
         }
@@ -954,6 +1742,17 @@ const AdminDashboardScreen = ({ navigation }) => {
               <Text style={styles.actionSubtitle}>Analytics & insights</Text>
             </TouchableOpacity>
 
+            <TouchableOpacity
+              style={styles.actionCard}
+              onPress={() => navigation.navigate('LiveSession')}
+            >
+              <View style={styles.actionIcon}>
+                <Text style={styles.actionEmoji}>🟢</Text>
+              </View>
+              <Text style={styles.actionTitle}>Live Session</Text>
+              <Text style={styles.actionSubtitle}>Today's check-ins</Text>
+            </TouchableOpacity>
+
             <TouchableOpacity
               style={styles.actionCard}
               onPress={() => navigation.navigate('CreateCourse')}
@@ -1216,6 +2015,62 @@ const CreateStudentScreen = ({ navigation }) => {
   );
 };
 
+const StudentRow = React.memo(({ student, onDelete }) => (
+  <View style={styles.studentItem}>
+    <CachedImage
+      path={student.profileImageHash ? `/images/students/${student.studentId}/${student.profileImageHash}` : null}
+      size={44}
+      style={styles.studentAvatar}
+      placeholder={
+        <View style={[styles.studentAvatar, styles.studentAvatarPlaceholder]}>
+          <Text style={styles.studentAvatarInitial}>{student.studentName?.charAt(0)?.toUpperCase()}</Text>
+        </View>
+      }
+    />
+    <View style={styles.studentInfo}>
+      <Text style={styles.studentName} numberOfLines={1}>{student.studentName}</Text>
+      <Text style={styles.studentIdText} numberOfLines={1}>ID: {student.studentId}</Text>
+      <Text style={styles.studentCourses} numberOfLines={1}>
+        Courses: {student.enrolledCourses?.join(', ') || 'None'}
+      </Text>
+    </View>
+    <View style={styles.studentActions}>
+      <TouchableOpacity
+        style={styles.deleteButton}
+        onPress={() => onDelete(student._id)}
+      >
+        <Text style={styles.deleteButtonText}>Delete</Text>
+      </TouchableOpacity>
+    </View>
+  </View>
+));
+
+const StudentList = ({ students, loading, onRefresh, onDelete }) => {
+  const renderStudent = useCallback(({ item }) => (
+    <StudentRow student={item} onDelete={onDelete} />
+  ), [onDelete]);
+
+  return (
+    <FlatList
+      data={students}
+      keyExtractor={keyById}
+      refreshing={loading}
+      onRefresh={onRefresh}
+      renderItem={renderStudent}
+      getItemLayout={getStudentRowLayout}
+      initialNumToRender={12}
+      maxToRenderPerBatch={20}
+      windowSize={7}
+      ListEmptyComponent={
+        <View style={styles.emptyState}>
+          <Text style={styles.emptyText}>No students found</Text>
+          <Text style={styles.emptySubtext}>Create your first student to get started</Text>
+        </View>
+      }
+    />
+  );
+};
+
 // View Students Screen
 const ViewStudentsScreen = ({ navigation }) => {
   const [students, setStudents] = useState([]);
@@ -1226,7 +2081,7 @@ const ViewStudentsScreen = ({ navigation }) => {
     loadStudents();
   }, []);
 
-  const loadStudents = async () => {
+  const loadStudents = useCallback(async () => {
     setLoading(true);
     try {
       const response = await apiCall('/admin/students');
@@ -1238,9 +2093,9 @@ const ViewStudentsScreen = ({ navigation }) => {
     } finally {
       setLoading(false);
     }
-  };
+  }, []);
 
-  const deleteStudent = (studentId) => {
+  const deleteStudent = useCallback((studentId) => {
     Alert.alert(
       'Delete Student',
       'Are you sure you want to delete this student? This action cannot be undone.',
@@ -1265,12 +2120,16 @@ const ViewStudentsScreen = ({ navigation }) => {
         }
       ]
     );
-  };
-
-  const filteredStudents = students.filter(student =>
-    student.studentName?.toLowerCase().includes(searchQuery.toLowerCase()) ||
-    student.studentId?.toLowerCase().includes(searchQuery.toLowerCase())
-  );
+  }, [loadStudents]);
+
+  const filteredStudents = useMemo(() => {
+    const query = searchQuery.trim().toLowerCase();
+    if (!query) return students;
+    return students.filter(student =>
+      student.studentName?.toLowerCase().includes(query) ||
+      student.studentId?.toLowerCase().includes(query)
+    );
+  }, [students, searchQuery]);
 
   return (
     <SafeAreaView style={styles.container}>
@@ -1283,36 +2142,11 @@ const ViewStudentsScreen = ({ navigation }) => {
         />
       </View>
 
-      <FlatList
-        data={filteredStudents}
-        keyExtractor={(item) => item._id}
-        refreshing={loading}
+      <StudentList
+        students={filteredStudents}
+        loading={loading}
         onRefresh={loadStudents}
-        renderItem={({ item }) => (
-          <View style={styles.studentItem}>
-            <View style={styles.studentInfo}>
-              <Text style={styles.studentName}>{item.studentName}</Text>
-              <Text style={styles.studentIdText}>ID: {item.studentId}</Text>
-              <Text style={styles.studentCourses}>
-                Courses: {item.enrolledCourses?.join(', ') || 'None'}
-              </Text>
-            </View>
-            <View style={styles.studentActions}>
-              <TouchableOpacity
-                style={styles.deleteButton}
-                onPress={() => deleteStudent(item._id)}
-              >
-                <Text style={styles.deleteButtonText}>Delete</Text>
-              </TouchableOpacity>
-            </View>
-          </View>
-        )}
-        ListEmptyComponent={
-          <View style={styles.emptyState}>
-            <Text style={styles.emptyText}>No students found</Text>
-            <Text style={styles.emptySubtext}>Create your first student to get started</Text>
-          </View>
-        }
+        onDelete={deleteStudent}
       />
     </SafeAreaView>
   );
@@ -1512,16 +2346,42 @@ const CreateCourseScreen = ({ navigation }) => {
   );
 };
 
-// Attendance Reports Screen
-const AttendanceReportsScreen = ({ navigation }) => {
-  const [reports, setReports] = useState({});
-  const [loading, setLoading] = useState(false);
-  const [selectedCourse, setSelectedCourse] = useState('');
+// Attendance Reports Screen, loaded on first visit so the web console's initial bundle leaves it out
+const AttendanceReportsScreen = React.lazy(() => {
+  const flow = startPerfFlow('reports_chunk');
+  return import('./screens/AttendanceReportsScreen').then((module) => {
+    flow.mark('loaded');
+    return module;
+  });
+});
+
+const AttendanceReportsRoute = (props) => (
+  <Suspense fallback={<LoadingScreen message="Loading reports..." />}>
+    <AttendanceReportsScreen {...props} />
+  </Suspense>
+);
+
+// Live Session Screen (instructor view of today's session, kept current by long polling)
+const LiveSessionScreen = ({ navigation }) => {
   const [courses, setCourses] = useState([]);
+  const [selectedCourse, setSelectedCourse] = useState('');
+  const [session, setSession] = useState(null);
+  const [connected, setConnected] = useState(false);
+  const streamRef = useRef({ active: false, courseCode: '' });
 
   useEffect(() => {
     loadCourses();
-    loadReports();
+    return () => { streamRef.current.active = false; };
+  }, []);
+
+  useEffect(() => {
+    streamRef.current = { active: false, courseCode: '' };
+    setSession(null);
+    if (selectedCourse) {
+      const stream = { active: true, courseCode: selectedCourse };
+      streamRef.current = stream;
+      runStream(stream);
+    }
   }, [selectedCourse]);
 
   const loadCourses = async () => {
@@ -1529,45 +2389,78 @@ const AttendanceReportsScreen = ({ navigation }) => {
       const response = await apiCall('/admin/courses');
       if (response.success) {
         setCourses(response.data || []);
+        if (!selectedCourse && response.data?.length > 0) {
+          setSelectedCourse(response.data[0].courseCode);
+        }
       }
     } catch (error) {
-      console.error('Failed to load courses:', error);
+      showError('Failed to load courses');
     }
   };
 
-  const loadReports = async () => {
-    setLoading(true);
-    try {
-      let params = '';
-      if (selectedCourse) params += `?courseCode=${selectedCourse}`;
-      
-      const response = await apiCall(`/admin/analytics${params}`);
-      if (response.success) {
-        setReports(response.data);
+  const applyChanges = (current, data) => {
+    if (data.roster) {
+      return data;
+    }
+    const roster = [...(current?.roster || [])];
+    data.changes.forEach(change => {
+      const index = roster.findIndex(entry => entry.studentId === change.studentId);
+      if (index >= 0) roster[index] = change;
+      else roster.push(change);
+    });
+    return { ...current, ...data, roster };
+  };
+
+  const runStream = async (stream) => {
+    let version = -1;
+    while (stream.active) {
+      try {
+        const endpoint = version < 0
+          ? `/admin/live/${stream.courseCode}`
+          : `/admin/live/${stream.courseCode}/stream?since=${version}`;
+        const response = await apiCall(endpoint);
+        if (!stream.active) return;
+        if (response.success) {
+          setConnected(true);
+          setSession(current => applyChanges(current, response.data));
+          version = response.data.closed ? -1 : response.data.version;
+        }
+      } catch (error) {
+        if (!stream.active) return;
+        setConnected(false);
+        await new Promise(resolve => setTimeout(resolve, 3000));
       }
-    } catch (error) {
-      showError('Failed to load reports');
-    } finally {
-      setLoading(false);
     }
   };
 
+  const counts = session?.counts || {};
+  const attended = (counts.present || 0) + (counts.late || 0);
+  const roster = [...(session?.roster || [])].sort((a, b) => {
+    if (!!a.status !== !!b.status) return a.status ? -1 : 1;
+    return String(a.studentName || '').localeCompare(String(b.studentName || ''));
+  });
+
   return (
     <SafeAreaView style={styles.container}>
       <View style={styles.reportsHeader}>
-        <Text style={styles.reportsTitle}>Attendance Reports</Text>
-        <Text style={styles.reportsSubtitle}>Analytics and insights</Text>
+        <Text style={styles.reportsTitle}>
+          {session ? `${attended}/${counts.enrolled || 0} present` : 'Live Session'}
+        </Text>
+        <Text style={styles.reportsSubtitle}>
+          {session
+            ? `${counts.late || 0} late · ${counts.notMarked || 0} not yet marked · ${connected ? 'live' : 'reconnecting...'}`
+            : 'Select a course to follow today\'s session'}
+        </Text>
       </View>
 
       <View style={styles.filterSection}>
-        <Text style={styles.filterLabel}>Filter by Course:</Text>
+        <Text style={styles.filterLabel}>Course:</Text>
         <View style={styles.pickerWrapper}>
           <Picker
             selectedValue={selectedCourse}
             style={styles.coursePicker}
             onValueChange={setSelectedCourse}
           >
-            <Picker.Item label="All Courses" value="" />
             {courses.map(course => (
               <Picker.Item
                 key={course.courseCode}
@@ -1579,64 +2472,70 @@ const AttendanceReportsScreen = ({ navigation }) => {
         </View>
       </View>
 
-      <ScrollView style={styles.reportsContainer}>
-        <View style={styles.reportCard}>
-          <Text style={styles.reportCardTitle}>Overview Statistics</Text>
-          <View style={styles.reportMetrics}>
-            <View style={styles.reportMetric}>
-              <Text style={styles.reportMetricValue}>{reports.overview?.totalStudents || 0}</Text>
-              <Text style={styles.reportMetricLabel}>Students</Text>
-            </View>
-            <View style={styles.reportMetric}>
-              <Text style={styles.reportMetricValue}>{reports.overview?.overallAttendanceRate || 0}%</Text>
-              <Text style={styles.reportMetricLabel}>Attendance Rate</Text>
+      <FlatList
+        data={roster}
+        keyExtractor={(item) => item.studentId}
+        renderItem={({ item }) => (
+          <View style={styles.historyItem}>
+            <View style={styles.historyDetails}>
+              <Text style={styles.historyCourse}>{item.studentName || item.studentId}</Text>
+              <Text style={styles.historyTime}>
+                {item.timestamp ? new Date(item.timestamp).toLocaleTimeString() : item.studentId}
+              </Text>
             </View>
-            <View style={styles.reportMetric}>
-              <Text style={styles.reportMetricValue}>{reports.overview?.totalAttendanceRecords || 0}</Text>
-              <Text style={styles.reportMetricLabel}>Total Records</Text>
+            <View style={[
+              styles.historyStatusBadge,
+              item.status === 'present' ? styles.presentBadge :
+              item.status === 'late' ? styles.lateBadge :
+              item.status ? styles.absentBadge : styles.pendingBadge
+            ]}>
+              <Text style={[
+                styles.historyStatusText,
+                item.status === 'present' ? styles.presentText :
+                item.status === 'late' ? styles.lateText :
+                item.status ? styles.absentText : styles.pendingText
+              ]}>
+                {item.status ? item.status.charAt(0).toUpperCase() + item.status.slice(1) : 'Waiting'}
+              </Text>
             </View>
           </View>
-        </View>
-
-        <View style={styles.reportCard}>
-          <Text style={styles.reportCardTitle}>Course Performance</Text>
-          {reports.coursePerformance?.map((course, index) => (
-            <View key={index} style={styles.coursePerformanceItem}>
-              <View style={styles.coursePerformanceHeader}>
-                <Text style={styles.courseCode}>{course.courseCode}</Text>
-                <Text style={styles.courseAttendanceRate}>{course.attendanceRate?.toFixed(1) || 0}%</Text>
-              </View>
-              <View style={styles.courseProgressBar}>
-                <View 
-                  style={[
-                    styles.progressFill,
-                    { width: `${course.attendanceRate || 0}%` }
-                  ]}
-                />
-              </View>
-            </View>
-          ))}
-        </View>
-
-        <View style={styles.reportCard}>
-          <Text style={styles.reportCardTitle}>Top Performing Students</Text>
-          {reports.topStudents?.map((student, index) => (
-            <View key={index} style={styles.topStudentItem}>
-              <Text style={styles.topStudentRank}>{index + 1}</Text>
-              <View style={styles.topStudentInfo}>
-                <Text style={styles.topStudentName}>{student.studentName}</Text>
-                <Text style={styles.topStudentId}>{student.studentId}</Text>
-              </View>
-              <Text style={styles.topStudentRate}>{student.attendanceRate?.toFixed(1) || 0}%</Text>
-            </View>
-          ))}
-        </View>
-      </ScrollView>
+        )}
+        ListEmptyComponent={
+          <View style={styles.emptyState}>
+            <Text style={styles.emptyText}>{session ? 'No students enrolled' : 'Connecting...'}</Text>
+          </View>
+        }
+      />
     </SafeAreaView>
   );
 };
 
 // Notifications Screen
+const NotificationRow = React.memo(({ notification, onMarkRead }) => (
+  <TouchableOpacity
+    style={[
+      styles.notificationItem,
+      !notification.isRead && styles.unreadNotification
+    ]}
+    onPress={() => !notification.isRead && onMarkRead(notification._id)}
+  >
+    <View style={styles.notificationIcon}>
+      <Text style={styles.notificationEmoji}>
+        {notification.type === 'success' ? '✅' : 
+         notification.type === 'warning' ? '⚠️' : 
+         notification.type === 'error' ? '❌' : 'ℹ️'}
+      </Text>
+    </View>
+    <View style={styles.notificationContent}>
+      <Text style={styles.notificationTitle}>{notification.title}</Text>
+      <Text style={styles.notificationMessage}>{notification.message}</Text>
+      <Text style={styles.notificationTime}>
+        {new Date(notification.createdAt).toLocaleString()}
+      </Text>
+    </View>
+  </TouchableOpacity>
+));
+
 const NotificationsScreen = ({ navigation }) => {
   const [notifications, setNotifications] = useState([]);
   const [loading, setLoading] = useState(false);
@@ -1646,22 +2545,24 @@ const NotificationsScreen = ({ navigation }) => {
     loadNotifications();
   }, []);
 
-  const loadNotifications = async () => {
+  const loadNotifications = useCallback(async () => {
     setLoading(true);
     try {
+      setNotifications(await queryLocalRows('SELECT data FROM notifications ORDER BY created_at DESC LIMIT 50'));
       const response = await apiCall('/notifications');
       if (response.success) {
         setNotifications(response.data.notifications || []);
         setUnreadCount(response.data.unreadCount || 0);
+        await upsertLocalRows('notifications', response.data.notifications || [], { replace: !response.data.pagination?.hasMore });
       }
     } catch (error) {
       showError('Failed to load notifications');
     } finally {
       setLoading(false);
     }
-  };
+  }, []);
 
-  const markAsRead = async (notificationId) => {
+  const markAsRead = useCallback(async (notificationId) => {
     try {
       const response = await apiCall(`/notifications/${notificationId}/read`, {
         method: 'PUT'
@@ -1672,7 +2573,11 @@ const NotificationsScreen = ({ navigation }) => {
     } catch (error) {
       showError('Failed to mark notification as read');
     }
-  };
+  }, [loadNotifications]);
+
+  const renderNotification = useCallback(({ item }) => (
+    <NotificationRow notification={item} onMarkRead={markAsRead} />
+  ), [markAsRead]);
 
   return (
     <SafeAreaView style={styles.container}>
@@ -1687,33 +2592,10 @@ const NotificationsScreen = ({ navigation }) => {
 
       <FlatList
         data={notifications}
-        keyExtractor={(item) => item._id}
+        keyExtractor={keyById}
         refreshing={loading}
         onRefresh={loadNotifications}
-        renderItem={({ item }) => (
-          <TouchableOpacity
-            style={[
-              styles.notificationItem,
-              !item.isRead && styles.unreadNotification
-            ]}
-            onPress={() => !item.isRead && markAsRead(item._id)}
-          >
-            <View style={styles.notificationIcon}>
-              <Text style={styles.notificationEmoji}>
-                {item.type === 'success' ? '✅' : 
-                 item.type === 'warning' ? '⚠️' : 
-                 item.type === 'error' ? '❌' : 'ℹ️'}
-              </Text>
-            </View>
-            <View style={styles.notificationContent}>
-              <Text style={styles.notificationTitle}>{item.title}</Text>
-              <Text style={styles.notificationMessage}>{item.message}</Text>
-              <Text style={styles.notificationTime}>
-                {new Date(item.createdAt).toLocaleString()}
-              </Text>
-            </View>
-          </TouchableOpacity>
-        )}
+        renderItem={renderNotification}
         ListEmptyComponent={
           <View style={styles.emptyState}>
             <Text style={styles.emptyText}>No notifications</Text>
@@ -1738,6 +2620,9 @@ const MaterialManagementScreen = ({ navigation }) => {
     courseCode: '',
     materialType: 'document'
   });
+  const [selectedFile, setSelectedFile] = useState(null);
+  const [uploadProgress, setUploadProgress] = useState(null);
+  const [revisionUpload, setRevisionUpload] = useState(null);
 
   useEffect(() => {
     loadCourses();
@@ -1755,18 +2640,60 @@ const MaterialManagementScreen = ({ navigation }) => {
     }
   };
 
-  const loadMaterials = async () => {
+  const loadMaterials = async () => {
+    try {
+      setLoading(true);
+      const courseCode = selectedCourse || 'ICT651';
+      const response = await apiCall(`/materials/${courseCode}`);
+      if (response.success) {
+        setMaterials(response.data.materials || []);
+      }
+    } catch (error) {
+      showError('Failed to load materials');
+    } finally {
+      setLoading(false);
+    }
+  };
+
+  const chooseDocument = async () => {
+    try {
+      const result = await DocumentPicker.getDocumentAsync({ copyToCacheDirectory: true });
+      if (result.canceled || !result.assets?.length) return null;
+
+      const asset = result.assets[0];
+      const size = asset.size ?? (await FileSystem.getInfoAsync(asset.uri, { size: true })).size;
+      return { uri: asset.uri, name: asset.name, size, mimeType: asset.mimeType };
+    } catch (error) {
+      showError('Failed to select file');
+      return null;
+    }
+  };
+
+  const pickFile = async () => {
+    const file = await chooseDocument();
+    if (file) setSelectedFile(file);
+  };
+
+  const uploadRevision = async (material) => {
+    if (revisionUpload) return;
+    const file = await chooseDocument();
+    if (!file) return;
+
     try {
-      setLoading(true);
-      const courseCode = selectedCourse || 'ICT651';
-      const response = await apiCall(`/materials/${courseCode}`);
+      setRevisionUpload({ id: material._id, progress: 0 });
+      const response = await uploadMaterialRevision(material._id, file, (progress) =>
+        setRevisionUpload({ id: material._id, progress })
+      );
       if (response.success) {
-        setMaterials(response.data.materials || []);
+        const sentMb = (response.transferBytes / (1024 * 1024)).toFixed(1);
+        const totalMb = (response.data.fileSize / (1024 * 1024)).toFixed(1);
+        showSuccess(`Revision ${response.data.revision} uploaded. Sent ${sentMb} MB of ${totalMb} MB.`);
+        loadMaterials();
       }
     } catch (error) {
-      showError('Failed to load materials');
+      showError(`${error.message}\nTry again to resume.`);
     } finally {
-      setLoading(false);
+      setRevisionUpload(null);
     }
   };
 
@@ -1775,21 +2702,31 @@ const MaterialManagementScreen = ({ navigation }) => {
       showError('Please fill required fields');
       return;
     }
+    if (uploadProgress !== null) return;
 
     try {
-      const response = await apiCall('/admin/materials', {
-        method: 'POST',
-        body: JSON.stringify(uploadData),
-      });
+      let response;
+      if (selectedFile) {
+        setUploadProgress(0);
+        response = await uploadMaterialFile(selectedFile, uploadData, setUploadProgress);
+      } else {
+        response = await apiCall('/admin/materials', {
+          method: 'POST',
+          body: JSON.stringify(uploadData),
+        });
+      }
 
       if (response.success) {
         showSuccess('Material uploaded successfully');
         setUploadModal(false);
         setUploadData({ title: '', description: '', courseCode: '', materialType: 'document' });
+        setSelectedFile(null);
         loadMaterials();
       }
     } catch (error) {
-      showError(error.message);
+      showError(selectedFile ? `${error.message}\nTap Upload again to resume.` : error.message);
+    } finally {
+      setUploadProgress(null);
     }
   };
 
@@ -1841,6 +2778,15 @@ const MaterialManagementScreen = ({ navigation }) => {
               </Text>
               <Text style={styles.materialType}>{item.materialType.toUpperCase()}</Text>
             </View>
+            {item.fileName && (
+              <TouchableOpacity style={styles.revisionButton} onPress={() => uploadRevision(item)}>
+                <Text style={styles.revisionButtonText}>
+                  {revisionUpload?.id === item._id
+                    ? `Uploading revision… ${Math.round(revisionUpload.progress * 100)}%`
+                    : `Upload Revision${item.revision > 1 ? ` (current: v${item.revision})` : ''}`}
+                </Text>
+              </TouchableOpacity>
+            )}
           </View>
         )}
         refreshing={loading}
@@ -1912,6 +2858,22 @@ const MaterialManagementScreen = ({ navigation }) => {
                 numberOfLines={3}
               />
             </View>
+
+            <View style={styles.inputGroup}>
+              <Text style={styles.inputLabel}>File</Text>
+              <TouchableOpacity style={styles.filePickerButton} onPress={pickFile}>
+                <Text style={styles.filePickerText} numberOfLines={1}>
+                  {selectedFile
+                    ? `${selectedFile.name} (${(selectedFile.size / (1024 * 1024)).toFixed(1)} MB)`
+                    : 'Choose a file (optional)'}
+                </Text>
+              </TouchableOpacity>
+              {uploadProgress !== null && (
+                <View style={styles.uploadProgressTrack}>
+                  <View style={[styles.uploadProgressFill, { width: `${Math.round(uploadProgress * 100)}%` }]} />
+                </View>
+              )}
+            </View>
           </ScrollView>
         </SafeAreaView>
       </Modal>
@@ -1929,12 +2891,19 @@ const StudentDashboardScreen = ({ navigation }) => {
   const [showFaceRegistration, setShowFaceRegistration] = useState(false);
   const [capturedImage, setCapturedImage] = useState(null);
   const [isRegistering, setIsRegistering] = useState(false);
+  const [perfFlow] = useState(() => startPerfFlow('student_dashboard'));
 
   useEffect(() => {
     loadDashboardData();
     checkFaceRegistration();
   }, []);
 
+  useEffect(() => {
+    if (!loading) {
+      requestAnimationFrame(() => perfFlow.mark('render'));
+    }
+  }, [loading]);
+
   const loadDashboardData = async () => {
     try {
       const info = await AsyncStorage.getItem('userInfo');
@@ -1943,6 +2912,7 @@ const StudentDashboardScreen = ({ navigation }) => {
       }
 
       const response = await apiCall('/student/dashboard');
+      perfFlow.mark('response');
       if (response.success) {
         setDashboardData(response.data);
       }
@@ -1970,6 +2940,10 @@ const StudentDashboardScreen = ({ navigation }) => {
           style: 'destructive',
           onPress: async () => {
             await AsyncStorage.multiRemove(['userToken', 'userRole', 'userInfo']);
+            etagCache.clear();
+            await clearLocalStore();
+            await clearMaterialCache();
+            await clearImageCache();
             navigation.replace('Login');
           }
         }
@@ -1998,12 +2972,12 @@ const StudentDashboardScreen = ({ navigation }) => {
         mediaTypes: ImagePicker.MediaTypeOptions.Images,
         allowsEditing: true,
         aspect: [1, 1],
-        quality: 0.8,
+        quality: 1,
         base64: false
       });
 
       if (!result.canceled) {
-        setCapturedImage(result.assets[0].uri);
+        setCapturedImage(result.assets[0]);
       }
     } catch (error) {
       showError('Failed to capture photo: ' + error.message);
@@ -2018,13 +2992,12 @@ const StudentDashboardScreen = ({ navigation }) => {
 
     setIsRegistering(true);
     try {
-      const base64 = await FileSystem.readAsStringAsync(capturedImage, { 
-        encoding: FileSystem.EncodingType.Base64 
-      });
+      // The registered face is the reference for every later match, so keep at least the medium tier
+      const { imageBase64, captureTier } = await prepareCaptureUpload(capturedImage, 'medium');
       
       const response = await apiCall('/student/face/register-image', {
         method: 'POST',
-        body: JSON.stringify({ imageBase64: base64 })
+        body: JSON.stringify({ imageBase64, captureTier })
       });
       
       if (response.success) {
@@ -2047,6 +3020,9 @@ const StudentDashboardScreen = ({ navigation }) => {
   if (loading) return <LoadingScreen message="Loading your dashboard..." />;
 
   const stats = dashboardData.statistics || {};
+  const streaksByCourse = {};
+  (dashboardData.streaks || []).forEach(streak => { streaksByCourse[streak.courseCode] = streak; });
+  const bestCurrentStreak = Math.max(0, ...(dashboardData.streaks || []).map(streak => streak.currentStreak || 0));
 
   return (
     <SafeAreaView style={styles.container}>
@@ -2095,6 +3071,12 @@ const StudentDashboardScreen = ({ navigation }) => {
               <View style={[styles.statBar, styles.absentBar]} />
             </View>
           </View>
+
+          {bestCurrentStreak > 0 && (
+            <Text style={styles.streakBanner}>
+              🔥 {bestCurrentStreak} session{bestCurrentStreak === 1 ? '' : 's'} in a row — keep it going!
+            </Text>
+          )}
         </View>
 
         {/* Quick Actions */}
@@ -2152,6 +3134,11 @@ const StudentDashboardScreen = ({ navigation }) => {
               <Text style={styles.courseStats}>
                 {stats.present + stats.late}/{stats.total} sessions attended
               </Text>
+              {streaksByCourse[courseCode] && (
+                <Text style={styles.courseStreak}>
+                  🔥 {streaksByCourse[courseCode].currentStreak || 0} in a row · best {streaksByCourse[courseCode].bestStreak || 0}
+                </Text>
+              )}
             </View>
           ))}
         </View>
@@ -2242,7 +3229,7 @@ const StudentDashboardScreen = ({ navigation }) => {
                 ) : (
                   <View style={styles.facePreviewSection}>
                     <View style={styles.facePreviewContainer}>
-                      <Image source={{ uri: capturedImage }} style={styles.facePreviewImage} />
+                      <Image source={{ uri: capturedImage.uri }} style={styles.facePreviewImage} />
                       <View style={styles.facePreviewOverlay}>
                         <Text style={styles.facePreviewText}>✓ Captured</Text>
                       </View>
@@ -2290,6 +3277,7 @@ const MarkAttendanceScreen = ({ navigation }) => {
   const [scanning, setScanning] = useState(false);
   const [matching, setMatching] = useState(false);
   const [permission, requestPermission] = useCameraPermissions();
+  const perfFlow = useRef(null);
 
   useEffect(() => {
     loadCourses();
@@ -2297,9 +3285,11 @@ const MarkAttendanceScreen = ({ navigation }) => {
 
   const loadCourses = async () => {
     try {
+      setCourses(await queryLocalRows('SELECT data FROM courses ORDER BY course_code'));
       const response = await apiCall('/student/courses');
       if (response.success) {
         setCourses(response.data);
+        await upsertLocalRows('courses', response.data, { replace: true });
       }
     } catch (error) {
       showError('Failed to load courses');
@@ -2320,6 +3310,7 @@ const MarkAttendanceScreen = ({ navigation }) => {
       }
     }
 
+    perfFlow.current = startPerfFlow('attendance');
     setCameraVisible(true);
     setScanning(true);
   };
@@ -2333,7 +3324,7 @@ const MarkAttendanceScreen = ({ navigation }) => {
         mediaTypes: ImagePicker.MediaTypeOptions.Images,
         allowsEditing: true,
         aspect: [1, 1],
-        quality: 0.8,
+        quality: 1,
         base64: false
       });
       if (result.canceled) {
@@ -2342,24 +3333,30 @@ const MarkAttendanceScreen = ({ navigation }) => {
         setMatching(false);
         return;
       }
-      const base64 = await FileSystem.readAsStringAsync(result.assets[0].uri, { encoding: FileSystem.EncodingType.Base64 });
+      perfFlow.current?.mark('capture');
+      const { imageBase64, captureTier } = await prepareCaptureUpload(result.assets[0]);
 
       // Simulate face matching process
       setTimeout(async () => {
         try {
+          perfFlow.current?.mark('upload_start');
           const response = await apiCall('/student/attendance-image', {
             method: 'POST',
             body: JSON.stringify({
               courseCode: selectedCourse,
-              imageBase64: base64,
+              imageBase64,
+              captureTier,
               location: { latitude: 0, longitude: 0 }
             }),
           });
 
+          perfFlow.current?.mark('response');
           if (response.success) {
             setCameraVisible(false);
             setScanning(false);
             setMatching(false);
+            const flow = perfFlow.current;
+            requestAnimationFrame(() => flow?.mark('render'));
             const attendanceData = response.data;
             Alert.alert(
               '✅ Attendance Recorded',
@@ -2386,7 +3383,7 @@ const MarkAttendanceScreen = ({ navigation }) => {
   if (cameraVisible) {
     return (
       <View style={styles.cameraContainer}>
-        <CameraView style={styles.camera} facing="front">
+        <CameraView style={styles.camera} facing="front" onCameraReady={() => perfFlow.current?.mark('camera_ready')}>
           <View style={styles.cameraOverlay}>
             <View style={styles.scanningFrame}>
               <View style={[styles.faceFrame, matching && styles.faceFrameMatching]} />
@@ -2520,21 +3517,121 @@ const MarkAttendanceScreen = ({ navigation }) => {
   );
 };
 
+// HLS playback of a video material; playback starts once the first (2s) segment has arrived
+const MaterialVideoPlayer = ({ material, token, onClose }) => {
+  const player = useVideoPlayer({
+    uri: `${API_BASE_URL}/materials/${material._id}/stream/${material.streaming.revision}/master.m3u8`,
+    headers: { Authorization: `Bearer ${token}` },
+  }, (videoPlayer) => {
+    videoPlayer.play();
+  });
+
+  return (
+    <SafeAreaView style={styles.modalContainer}>
+      <View style={styles.modalHeader}>
+        <TouchableOpacity onPress={onClose}>
+          <Text style={styles.modalCancel}>Close</Text>
+        </TouchableOpacity>
+        <Text style={styles.modalTitle} numberOfLines={1}>{material.title}</Text>
+        <View style={styles.headerSpacer} />
+      </View>
+      <VideoView style={styles.videoView} player={player} allowsFullscreen nativeControls />
+    </SafeAreaView>
+  );
+};
+
+// `progress` and `offline` are passed per row so a download only re-renders its own row
+const StudentMaterialRow = React.memo(({ material, progress, offline, onDownload, onPlay }) => (
+  <View style={styles.materialItem}>
+    <View style={styles.materialIcon}>
+      {material.materialType === 'image' && material.fileHash ? (
+        <CachedImage path={`/images/materials/${material._id}/${material.fileHash}`} size={40} style={styles.materialPreview} />
+      ) : (
+        <Text style={styles.materialTypeIcon}>
+          {material.materialType === 'pdf' ? '📄' : 
+           material.materialType === 'image' ? '🖼️' : 
+           material.materialType === 'video' ? '🎬' : 
+           material.materialType === 'link' ? '🔗' : '📎'}
+        </Text>
+      )}
+    </View>
+    <View style={styles.materialContent}>
+      <Text style={styles.materialTitle}>{material.title}</Text>
+      <Text style={styles.materialCourse}>{material.courseCode}</Text>
+      <Text style={styles.materialDate}>
+        {new Date(material.createdAt).toLocaleDateString()}
+      </Text>
+    </View>
+    {material.streaming?.status === 'ready' ? (
+      <TouchableOpacity style={styles.downloadButton} onPress={() => onPlay(material)}>
+        <Text style={styles.downloadIcon}>▶</Text>
+      </TouchableOpacity>
+    ) : material.streaming?.status === 'pending' || material.streaming?.status === 'processing' ? (
+      <Text style={styles.videoProcessingText}>Processing…</Text>
+    ) : (
+      <TouchableOpacity
+        style={[styles.downloadButton, offline && styles.offlineButton]}
+        onPress={() => onDownload(material)}
+      >
+        <Text style={styles.downloadIcon}>
+          {progress !== undefined
+            ? `${Math.round(progress * 100)}`
+            : offline ? '✓' : '⬇'}
+        </Text>
+      </TouchableOpacity>
+    )}
+  </View>
+));
+
 // Student Materials Screen
 const StudentMaterialsScreen = () => {
   const [materials, setMaterials] = useState([]);
   const [loading, setLoading] = useState(false);
+  const [searchQuery, setSearchQuery] = useState('');
+  const [searchResults, setSearchResults] = useState(null);
+  const [playingVideo, setPlayingVideo] = useState(null);
+  const [downloadProgress, setDownloadProgress] = useState({});
+  const [offlineVersion, setOfflineVersion] = useState(0);
+  const searchTimer = useRef(null);
 
   useEffect(() => {
+    loadMaterialCacheIndex().then(() => setOfflineVersion(version => version + 1));
     loadStudentMaterials();
+    return () => clearTimeout(searchTimer.current);
   }, []);
 
+  const onSearchChange = (text) => {
+    setSearchQuery(text);
+    clearTimeout(searchTimer.current);
+    if (!text.trim()) {
+      setSearchResults(null);
+      return;
+    }
+    searchTimer.current = setTimeout(() => searchMaterials(text), 250);
+  };
+
+  const searchMaterials = async (query) => {
+    try {
+      const response = await apiCall(`/materials/search?q=${encodeURIComponent(query)}`);
+      if (response.success) {
+        setSearchResults(response.data.results || []);
+      }
+    } catch (error) {
+      console.error('Material search failed:', error);
+    }
+  };
+
   const loadStudentMaterials = async () => {
     try {
       setLoading(true);
+      setMaterials(await queryLocalRows('SELECT data FROM materials ORDER BY created_at DESC'));
       const response = await apiCall('/student/materials');
       if (response.success) {
         setMaterials(response.data.materials || []);
+        await upsertLocalRows('materials', response.data.materials || [], { replace: !response.data.pagination?.hasMore });
+        prefetchNewMaterials(response.data.materials || []).then(fetched => {
+          if (fetched) setOfflineVersion(version => version + 1);
+        });
       }
     } catch (error) {
       showError('Failed to load materials');
@@ -2543,14 +3640,37 @@ const StudentMaterialsScreen = () => {
     }
   };
 
-  const downloadMaterial = async (materialId, fileName) => {
+  const downloadMaterial = useCallback(async (material) => {
     try {
-      // In a real implementation, this would trigger the download
-      showSuccess(`${fileName} download started`);
+      setDownloadProgress(progress => ({ ...progress, [material._id]: 0 }));
+      const result = await getOfflineMaterial(material, {
+        onProgress: (value) => setDownloadProgress(progress => ({ ...progress, [material._id]: value })),
+      });
+      setOfflineVersion(version => version + 1);
+      showSuccess(result.transferred
+        ? `${material.fileName} saved for offline use`
+        : `${material.fileName} is already available offline`);
     } catch (error) {
-      showError('Failed to download material');
+      showError(`Download interrupted: ${error.message}. Tap again to resume.`);
+    } finally {
+      setDownloadProgress(({ [material._id]: removed, ...progress }) => progress);
     }
-  };
+  }, []);
+
+  const playVideo = useCallback(async (material) => {
+    const token = await AsyncStorage.getItem('userToken');
+    setPlayingVideo({ material, token });
+  }, []);
+
+  const renderMaterial = ({ item }) => (
+    <StudentMaterialRow
+      material={item}
+      progress={downloadProgress[item._id]}
+      offline={isMaterialCached(item)}
+      onDownload={downloadMaterial}
+      onPlay={playVideo}
+    />
+  );
 
   return (
     <SafeAreaView style={styles.container}>
@@ -2559,46 +3679,109 @@ const StudentMaterialsScreen = () => {
         <Text style={styles.materialsSubtitle}>Access your learning resources</Text>
       </View>
 
+      <View style={styles.searchContainer}>
+        <TextInput
+          style={styles.searchInput}
+          placeholder="Search materials, e.g. week 5 lab"
+          value={searchQuery}
+          onChangeText={onSearchChange}
+          autoCorrect={false}
+          returnKeyType="search"
+        />
+      </View>
+
       <FlatList
-        data={materials}
-        keyExtractor={(item) => item._id}
-        renderItem={({ item }) => (
-          <View style={styles.materialItem}>
-            <View style={styles.materialIcon}>
-              <Text style={styles.materialTypeIcon}>
-                {item.materialType === 'pdf' ? '📄' : 
-                 item.materialType === 'image' ? '🖼️' : 
-                 item.materialType === 'link' ? '🔗' : '📎'}
-              </Text>
-            </View>
-            <View style={styles.materialContent}>
-              <Text style={styles.materialTitle}>{item.title}</Text>
-              <Text style={styles.materialCourse}>{item.courseCode}</Text>
-              <Text style={styles.materialDate}>
-                {new Date(item.createdAt).toLocaleDateString()}
-              </Text>
-            </View>
-            <TouchableOpacity
-              style={styles.downloadButton}
-              onPress={() => downloadMaterial(item._id, item.fileName)}
-            >
-              <Text style={styles.downloadIcon}>⬇</Text>
-            </TouchableOpacity>
-          </View>
-        )}
+        data={searchResults || materials}
+        keyExtractor={keyById}
+        renderItem={renderMaterial}
+        extraData={[downloadProgress, offlineVersion]}
         refreshing={loading}
         onRefresh={loadStudentMaterials}
         ListEmptyComponent={
           <View style={styles.emptyState}>
-            <Text style={styles.emptyText}>No materials available</Text>
-            <Text style={styles.emptySubtext}>Materials will appear here when uploaded by instructors</Text>
+            <Text style={styles.emptyText}>{searchResults ? 'No matching materials' : 'No materials available'}</Text>
+            <Text style={styles.emptySubtext}>
+              {searchResults ? 'Try a different search term' : 'Materials will appear here when uploaded by instructors'}
+            </Text>
           </View>
         }
       />
+
+      <Modal
+        visible={playingVideo !== null}
+        animationType="slide"
+        presentationStyle="pageSheet"
+        onRequestClose={() => setPlayingVideo(null)}
+      >
+        {playingVideo && (
+          <MaterialVideoPlayer
+            material={playingVideo.material}
+            token={playingVideo.token}
+            onClose={() => setPlayingVideo(null)}
+          />
+        )}
+      </Modal>
     </SafeAreaView>
   );
 };
 
+const AttendanceHistoryRow = React.memo(({ record }) => {
+  const timestamp = new Date(record.timestamp);
+  return (
+    <View style={styles.historyItem}>
+      <View style={styles.historyDate}>
+        <Text style={styles.historyDay}>
+          {timestamp.getDate()}
+        </Text>
+        <Text style={styles.historyMonth}>
+          {timestamp.toLocaleDateString('en', { month: 'short' })}
+        </Text>
+      </View>
+      <View style={styles.historyDetails}>
+        <Text style={styles.historyCourse} numberOfLines={1}>{record.courseCode}</Text>
+        <Text style={styles.historyTime} numberOfLines={1}>
+          {timestamp.toLocaleTimeString()}
+        </Text>
+      </View>
+      <View style={[
+        styles.historyStatusBadge,
+        record.status === 'present' ? styles.presentBadge :
+        record.status === 'late' ? styles.lateBadge : styles.absentBadge
+      ]}>
+        <Text style={[
+          styles.historyStatusText,
+          record.status === 'present' ? styles.presentText :
+          record.status === 'late' ? styles.lateText : styles.absentText
+        ]}>
+          {record.status.charAt(0).toUpperCase() + record.status.slice(1)}
+        </Text>
+      </View>
+    </View>
+  );
+});
+
+const renderHistoryRow = ({ item }) => <AttendanceHistoryRow record={item} />;
+
+const AttendanceHistoryList = ({ records, loading, onRefresh }) => (
+  <FlatList
+    data={records}
+    keyExtractor={keyById}
+    refreshing={loading}
+    onRefresh={onRefresh}
+    renderItem={renderHistoryRow}
+    getItemLayout={getHistoryRowLayout}
+    initialNumToRender={12}
+    maxToRenderPerBatch={20}
+    windowSize={7}
+    ListEmptyComponent={
+      <View style={styles.emptyState}>
+        <Text style={styles.emptyText}>No attendance records found</Text>
+        <Text style={styles.emptySubtext}>Start marking attendance to see your history</Text>
+      </View>
+    }
+  />
+);
+
 // Attendance History Screen
 const AttendanceHistoryScreen = ({ navigation }) => {
   const [attendanceHistory, setAttendanceHistory] = useState([]);
@@ -2612,10 +3795,9 @@ const AttendanceHistoryScreen = ({ navigation }) => {
   const loadAttendanceHistory = async () => {
     setLoading(true);
     try {
-      const response = await apiCall('/student/dashboard');
-      if (response.success && response.data.recentAttendance) {
-        setAttendanceHistory(response.data.recentAttendance);
-      }
+      setAttendanceHistory(await queryLocalAttendance(selectedFilter));
+      await syncAttendanceHistory();
+      setAttendanceHistory(await queryLocalAttendance(selectedFilter));
     } catch (error) {
       showError('Failed to load attendance history');
     } finally {
@@ -2623,11 +3805,6 @@ const AttendanceHistoryScreen = ({ navigation }) => {
     }
   };
 
-  const getFilteredHistory = () => {
-    if (selectedFilter === 'all') return attendanceHistory;
-    return attendanceHistory.filter(record => record.status === selectedFilter);
-  };
-
   return (
     <SafeAreaView style={styles.container}>
       <View style={styles.historyHeader}>
@@ -2655,54 +3832,18 @@ const AttendanceHistoryScreen = ({ navigation }) => {
         ))}
       </View>
 
-      <FlatList
-        data={getFilteredHistory()}
-        keyExtractor={(item) => item._id}
-        refreshing={loading}
+      <AttendanceHistoryList
+        records={attendanceHistory}
+        loading={loading}
         onRefresh={loadAttendanceHistory}
-        renderItem={({ item }) => (
-          <View style={styles.historyItem}>
-            <View style={styles.historyDate}>
-              <Text style={styles.historyDay}>
-                {new Date(item.timestamp).getDate()}
-              </Text>
-              <Text style={styles.historyMonth}>
-                {new Date(item.timestamp).toLocaleDateString('en', { month: 'short' })}
-              </Text>
-            </View>
-            <View style={styles.historyDetails}>
-              <Text style={styles.historyCourse}>{item.courseCode}</Text>
-              <Text style={styles.historyTime}>
-                {new Date(item.timestamp).toLocaleTimeString()}
-              </Text>
-            </View>
-            <View style={[
-              styles.historyStatusBadge,
-              item.status === 'present' ? styles.presentBadge :
-              item.status === 'late' ? styles.lateBadge : styles.absentBadge
-            ]}>
-              <Text style={[
-                styles.historyStatusText,
-                item.status === 'present' ? styles.presentText :
-                item.status === 'late' ? styles.lateText : styles.absentText
-              ]}>
-                {item.status.charAt(0).toUpperCase() + item.status.slice(1)}
-              </Text>
-            </View>
-          </View>
-        )}
-        ListEmptyComponent={
-          <View style={styles.emptyState}>
-            <Text style={styles.emptyText}>No attendance records found</Text>
-            <Text style={styles.emptySubtext}>Start marking attendance to see your history</Text>
-          </View>
-        }
       />
     </SafeAreaView>
   );
 };
 
 // Main App Component
+const webLoadFlow = Platform.OS === 'web' ? startPerfFlow('web_console', 0) : null;
+
 export default function App() {
   const [initialRoute, setInitialRoute] = useState(null);
 
@@ -2710,6 +3851,12 @@ export default function App() {
     checkAuthState();
   }, []);
 
+  useEffect(() => {
+    if (initialRoute) {
+      requestAnimationFrame(() => webLoadFlow?.mark('first_screen'));
+    }
+  }, [initialRoute]);
+
   const checkAuthState = async () => {
     try {
       const token = await AsyncStorage.getItem('userToken');
@@ -2782,9 +3929,14 @@ export default function App() {
         />
         <Stack.Screen
           name="AttendanceReports"
-          component={AttendanceReportsScreen}
+          component={AttendanceReportsRoute}
           options={{ title: 'Attendance Reports' }}
         />
+        <Stack.Screen
+          name="LiveSession"
+          component={LiveSessionScreen}
+          options={{ title: 'Live Session' }}
+        />
         <Stack.Screen
           name="Notifications"
           component={NotificationsScreen}
@@ -3463,6 +4615,7 @@ const styles = StyleSheet.create({
   },
   studentItem: {
     flexDirection: 'row',
+    height: STUDENT_ROW_HEIGHT,
     backgroundColor: '#fff',
     padding: 16,
     borderBottomWidth: 1,
@@ -3472,6 +4625,22 @@ const styles = StyleSheet.create({
   studentInfo: {
     flex: 1,
   },
+  studentAvatar: {
+    width: 44,
+    height: 44,
+    borderRadius: 22,
+    marginRight: 12,
+  },
+  studentAvatarPlaceholder: {
+    backgroundColor: '#e3f2fd',
+    justifyContent: 'center',
+    alignItems: 'center',
+  },
+  studentAvatarInitial: {
+    fontSize: 18,
+    fontWeight: '600',
+    color: '#1976D2',
+  },
   studentName: {
     fontSize: 16,
     fontWeight: '600',
@@ -3655,6 +4824,19 @@ const styles = StyleSheet.create({
     color: '#666',
     fontWeight: '500',
   },
+  courseStreak: {
+    fontSize: 12,
+    color: '#FF9800',
+    fontWeight: '600',
+    marginTop: 4,
+  },
+  streakBanner: {
+    fontSize: 14,
+    color: '#FF9800',
+    fontWeight: '600',
+    textAlign: 'center',
+    marginTop: 16,
+  },
 
   // Recent Activity
   recentSection: {
@@ -3889,6 +5071,65 @@ const styles = StyleSheet.create({
     fontWeight: 'bold',
     color: '#4CAF50',
   },
+  heatmapRow: {
+    flexDirection: 'row',
+    alignItems: 'center',
+  },
+  heatmapRowLabel: {
+    width: 36,
+    fontSize: 11,
+    color: '#666',
+    fontWeight: '500',
+  },
+  heatmapHourLabel: {
+    width: 30,
+    marginHorizontal: 1,
+    fontSize: 10,
+    color: '#666',
+    textAlign: 'center',
+    marginBottom: 4,
+  },
+  heatmapCell: {
+    width: 30,
+    height: 24,
+    margin: 1,
+    borderRadius: 4,
+    justifyContent: 'center',
+    alignItems: 'center',
+  },
+  heatmapCellEmpty: {
+    backgroundColor: '#f0f0f0',
+  },
+  heatmapCellText: {
+    fontSize: 10,
+    fontWeight: '600',
+    color: '#fff',
+  },
+  heatmapCaption: {
+    fontSize: 12,
+    color: '#666',
+    marginTop: 12,
+  },
+  trendChart: {
+    height: 120,
+    flexDirection: 'row',
+    alignItems: 'flex-end',
+  },
+  trendBar: {
+    flex: 1,
+    marginHorizontal: 0.5,
+    borderTopLeftRadius: 1,
+    borderTopRightRadius: 1,
+  },
+  trendAxis: {
+    flexDirection: 'row',
+    justifyContent: 'space-between',
+    marginTop: 6,
+  },
+  trendAxisLabel: {
+    fontSize: 11,
+    color: '#999',
+  },
 
   // Notifications
   notificationsHeader: {
@@ -4096,6 +5337,43 @@ const styles = StyleSheet.create({
     backgroundColor: '#fafafa',
     color: '#333',
   },
+  filePickerButton: {
+    borderWidth: 1,
+    borderColor: '#e0e0e0',
+    borderStyle: 'dashed',
+    borderRadius: 8,
+    paddingHorizontal: 12,
+    paddingVertical: 14,
+    backgroundColor: '#fafafa',
+  },
+  filePickerText: {
+    fontSize: 15,
+    color: '#555',
+  },
+  revisionButton: {
+    marginTop: 10,
+    paddingVertical: 8,
+    borderRadius: 6,
+    borderWidth: 1,
+    borderColor: '#4CAF50',
+    alignItems: 'center',
+  },
+  revisionButtonText: {
+    fontSize: 14,
+    fontWeight: '600',
+    color: '#4CAF50',
+  },
+  uploadProgressTrack: {
+    height: 6,
+    borderRadius: 3,
+    backgroundColor: '#e0e0e0',
+    marginTop: 10,
+    overflow: 'hidden',
+  },
+  uploadProgressFill: {
+    height: '100%',
+    backgroundColor: '#4CAF50',
+  },
   modalPicker: {
     height: 50,
     color: '#333',
@@ -4325,6 +5603,9 @@ const styles = StyleSheet.create({
   materialTypeIcon: {
     fontSize: 24,
   },
+  materialPreview: {
+    borderRadius: 20,
+  },
   materialContent: {
     flex: 1,
   },
@@ -4336,6 +5617,22 @@ const styles = StyleSheet.create({
     justifyContent: 'center',
     alignItems: 'center',
   },
+  offlineButton: {
+    backgroundColor: '#4CAF50',
+  },
+  videoProcessingText: {
+    fontSize: 12,
+    color: '#999',
+    fontStyle: 'italic',
+  },
+  headerSpacer: {
+    width: 50,
+  },
+  videoView: {
+    width: '100%',
+    aspectRatio: 16 / 9,
+    backgroundColor: '#000',
+  },
   downloadIcon: {
     color: '#fff',
     fontSize: 18,
@@ -4388,6 +5685,7 @@ const styles = StyleSheet.create({
   },
   historyItem: {
     flexDirection: 'row',
+    height: HISTORY_ROW_HEIGHT,
     backgroundColor: '#fff',
     padding: 16,
     borderBottomWidth: 1,
@@ -4452,6 +5750,12 @@ const styles = StyleSheet.create({
   absentText: {
     color: '#F44336',
   },
+  pendingBadge: {
+    backgroundColor: '#f0f0f0',
+  },
+  pendingText: {
+    color: '#666',
+  },
 
   // Empty States
   emptyState: {
@@ -4740,4 +6044,17 @@ const styles = StyleSheet.create({
     color: '#1565c0',
     lineHeight: 20,
   },
-});
\ No newline at end of file
+});
+
+// Shared with the lazily loaded screens in ./screens
+export { apiCall, showError, pad2, EMPTY_LIST, styles };
+
+// List rows and their fixed heights, for the list rendering tests
+export {
+  STUDENT_ROW_HEIGHT,
+  HISTORY_ROW_HEIGHT,
+  StudentRow,
+  StudentList,
+  AttendanceHistoryRow,
+  AttendanceHistoryList,
+};
@@ -0,0 +1,20 @@
+// Deterministic list fixtures shaped like the API records the screens render
+const COURSES = ['CS101', 'MATH201', 'PHY110'];
+const STATUSES = ['present', 'present', 'present', 'late', 'absent'];
+
+export const makeStudents = (count) =>
+  Array.from({ length: count }, (_, i) => ({
+    _id: `student-${i}`,
+    studentId: `STU${String(i).padStart(5, '0')}`,
+    studentName: `Student ${i}`,
+    enrolledCourses: COURSES.slice(0, 1 + (i % COURSES.length)),
+    profileImageHash: null,
+  }));
+
+export const makeAttendanceRecords = (count) =>
+  Array.from({ length: count }, (_, i) => ({
+    _id: `attendance-${i}`,
+    courseCode: COURSES[i % COURSES.length],
+    status: STATUSES[i % STATUSES.length],
+    timestamp: new Date(Date.UTC(2025, 0, 6, 9) + i * 60 * 60 * 1000).toISOString(),
+  }));
@@ -0,0 +1,43 @@
+import React from 'react';
+import renderer, { act } from 'react-test-renderer';
+import { StudentList, AttendanceHistoryList } from '../../App';
+import { makeStudents, makeAttendanceRecords } from './fixtures';
+
+// Virtualization keeps the first render flat as the list grows: short lists mount every row,
+// longer ones only the initialNumToRender window. Mount and re-render timings are measured by
+// `npm run bench:lists` (benchmarks/list-rendering.bench.js).
+const INITIAL_ROWS = 12;
+const SIZES = [10, 1000, 10000];
+
+const noop = () => {};
+const LISTS = [
+  {
+    name: 'StudentList',
+    fixture: makeStudents,
+    rowProp: 'student',
+    render: (data) => <StudentList students={data} loading={false} onRefresh={noop} onDelete={noop} />,
+  },
+  {
+    name: 'AttendanceHistoryList',
+    fixture: makeAttendanceRecords,
+    rowProp: 'record',
+    render: (data) => <AttendanceHistoryList records={data} loading={false} onRefresh={noop} />,
+  },
+];
+
+describe('list rendering', () => {
+  for (const list of LISTS) {
+    for (const size of SIZES) {
+      test(`${list.name} mounts ${Math.min(size, INITIAL_ROWS)} of ${size} rows`, () => {
+        let tree;
+        act(() => {
+          tree = renderer.create(list.render(list.fixture(size)));
+        });
+        const rows = tree.root.findAll((node) => typeof node.type !== 'string' && list.rowProp in node.props);
+        act(() => tree.unmount());
+
+        expect(rows).toHaveLength(Math.min(size, INITIAL_ROWS));
+      });
+    }
+  }
+});
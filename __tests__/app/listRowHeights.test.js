@@ -0,0 +1,45 @@
+import React from 'react';
+import { StyleSheet } from 'react-native';
+import renderer, { act } from 'react-test-renderer';
+import {
+  STUDENT_ROW_HEIGHT,
+  HISTORY_ROW_HEIGHT,
+  StudentRow,
+  AttendanceHistoryRow,
+} from '../../App';
+import { makeStudents, makeAttendanceRecords } from './fixtures';
+
+// getItemLayout gives every row the same length, so the outer view of each row has to render
+// at exactly that height with no vertical margin, or FlatList offsets drift while scrolling
+const outerRowStyle = (element) => {
+  let tree;
+  act(() => {
+    tree = renderer.create(element);
+  });
+  const outer = tree.root.findAll((node) => typeof node.type === 'string')[0];
+  const style = StyleSheet.flatten(outer.props.style);
+  act(() => tree.unmount());
+  return style;
+};
+
+const expectFixedHeight = (style, rowHeight) => {
+  expect(style.height).toBe(rowHeight);
+  expect(style.minHeight ?? rowHeight).toBeLessThanOrEqual(rowHeight);
+  expect(style.maxHeight ?? rowHeight).toBeGreaterThanOrEqual(rowHeight);
+  for (const margin of ['margin', 'marginVertical', 'marginTop', 'marginBottom']) {
+    expect(style[margin] ?? 0).toBe(0);
+  }
+};
+
+describe('fixed-height list rows', () => {
+  test('student rows render at STUDENT_ROW_HEIGHT', () => {
+    const [student] = makeStudents(1);
+    expectFixedHeight(outerRowStyle(<StudentRow student={student} onDelete={() => {}} />), STUDENT_ROW_HEIGHT);
+  });
+
+  test('attendance history rows render at HISTORY_ROW_HEIGHT for every status', () => {
+    for (const record of makeAttendanceRecords(5)) {
+      expectFixedHeight(outerRowStyle(<AttendanceHistoryRow record={record} />), HISTORY_ROW_HEIGHT);
+    }
+  });
+});
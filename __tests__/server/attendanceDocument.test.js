@@ -0,0 +1,78 @@
+const mongoose = require('mongoose');
+const { Attendance, shapeAttendanceDocument } = require('../../server');
+
+// insertAttendance writes shapeAttendanceDocument() straight to the driver; it has to store the
+// same document Attendance#save() would for the same input. save() inserts toObject() with the
+// version key added, so that is the reference. MongoDB keeps _id first whatever the input order,
+// so key order is compared without it.
+const savedDocument = (fields) => ({
+  ...new Attendance(fields).toObject({ depopulate: true, transform: false, virtuals: false, getters: false }),
+  __v: 0
+});
+
+const storedKeys = (document) =>
+  Object.keys(document).filter(key => key !== '_id' && document[key] !== undefined);
+
+const expectSameDocument = (fields) => {
+  const withIdentity = {
+    _id: new mongoose.Types.ObjectId(),
+    timestamp: new Date('2025-03-04T09:07:00.000Z'),
+    createdAt: new Date('2025-03-04T09:07:01.000Z'),
+    ...fields
+  };
+  const shaped = shapeAttendanceDocument(withIdentity);
+  const expected = savedDocument(withIdentity);
+
+  expect(shaped).toEqual(expected);
+  expect(storedKeys(shaped)).toEqual(storedKeys(expected));
+  expect(Object.values(shaped)).not.toContain(undefined);
+};
+
+const REQUIRED = { studentId: 'STU001', courseCode: 'CS101', date: '2025-03-04' };
+
+describe('shapeAttendanceDocument', () => {
+  test('fills schema defaults', () => {
+    expectSameDocument({ ...REQUIRED });
+  });
+
+  test('matches a fully populated submission', () => {
+    expectSameDocument({
+      ...REQUIRED,
+      studentName: 'Ada Lovelace',
+      status: 'late',
+      confidenceScore: 0.91,
+      location: { latitude: 6.5244, longitude: 3.3792 },
+      deviceInfo: 'Pixel 8',
+      ipAddress: '10.0.0.12',
+      method: 'face_recognition',
+      notes: 'Arrived after the quiz',
+      captureTier: 'medium',
+      isLate: true,
+      lateMinutes: 7
+    });
+  });
+
+  test('keeps falsy values instead of defaulting them', () => {
+    expectSameDocument({ ...REQUIRED, confidenceScore: 0, isLate: false, lateMinutes: 0 });
+  });
+
+  test('omits an empty location', () => {
+    expectSameDocument({ ...REQUIRED, location: {} });
+  });
+
+  test('keeps a partial location and casts coordinates', () => {
+    expectSameDocument({ ...REQUIRED, location: { latitude: '6.5244' } });
+  });
+
+  test('omits fields passed as undefined', () => {
+    expectSameDocument({ ...REQUIRED, notes: undefined, deviceInfo: undefined, verifiedBy: undefined });
+  });
+
+  test('records manual entries', () => {
+    expectSameDocument({ ...REQUIRED, method: 'manual', status: 'excused', verifiedBy: 'admin001', confidenceScore: 1 });
+  });
+
+  test('stores __v: 0 like a first save', () => {
+    expect(shapeAttendanceDocument({ ...REQUIRED }).__v).toBe(0);
+  });
+});
@@ -0,0 +1,49 @@
+// CPU cost of building one attendance insert: shapeAttendanceDocument() as insertAttendance
+// uses it, against hydrating, validating and serialising an Attendance document as save() does.
+// No database is involved; the driver's insert is the same for both.
+//
+//   node benchmarks/attendance-insert.js [iterations]
+
+const { Attendance, shapeAttendanceDocument } = require('../server');
+
+const ITERATIONS = Number(process.argv[2]) || 200000;
+const WARMUP = Math.min(ITERATIONS, 20000);
+
+const fields = {
+  studentId: 'STU001',
+  studentName: 'Ada Lovelace',
+  courseCode: 'CS101',
+  date: '2025-03-04',
+  status: 'late',
+  confidenceScore: 0.91,
+  location: { latitude: 6.5244, longitude: 3.3792 },
+  deviceInfo: 'Pixel 8',
+  ipAddress: '10.0.0.12',
+  method: 'face_recognition',
+  captureTier: 'medium',
+  isLate: true,
+  lateMinutes: 7
+};
+
+const viaMongoose = () => {
+  const document = new Attendance(fields);
+  const error = document.validateSync();
+  if (error) throw error;
+  return document.toObject({ depopulate: true, transform: false, virtuals: false, getters: false });
+};
+
+const viaShape = () => shapeAttendanceDocument(fields);
+
+const run = (name, fn) => {
+  for (let i = 0; i < WARMUP; i++) fn();
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < ITERATIONS; i++) fn();
+  const nsPerOp = Number(process.hrtime.bigint() - start) / ITERATIONS;
+  console.log(`${name.padEnd(32)} ${nsPerOp.toFixed(0).padStart(8)} ns/op`);
+  return nsPerOp;
+};
+
+console.log(`attendance insert document, ${ITERATIONS} iterations (node ${process.version})`);
+const hydrated = run('new Attendance + validate', viaMongoose);
+const shaped = run('shapeAttendanceDocument', viaShape);
+console.log(`speedup: ${(hydrated / shaped).toFixed(1)}x`);
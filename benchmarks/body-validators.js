@@ -0,0 +1,63 @@
+// Cost of the compiled body validators (BODY_SCHEMAS). Times the attendance validator against
+// the hand-written checks it replaced, which only covered courseCode and faceData, and the
+// student and course validators on typical bodies and on early rejections.
+//
+//   node benchmarks/body-validators.js [iterations]
+
+const assert = require('assert');
+const { bodyValidators } = require('../server');
+
+const ITERATIONS = Number(process.argv[2]) || 200000;
+const WARMUP = Math.min(ITERATIONS, 10000);
+
+const attendance = {
+  courseCode: ' cs101 ',
+  faceData: Array.from({ length: 128 }, (_, i) => Math.sin(i)),
+  location: { latitude: '6.5244', longitude: 3.3792 },
+  notes: ' arrived late ',
+  extra: 'dropped'
+};
+const student = {
+  studentName: 'Ada Lovelace',
+  studentId: 'STU001',
+  dateOfBirth: '2001-12-10',
+  enrolledCourses: ['cs101', 'math201'],
+  email: 'ada@example.com',
+  emergencyContact: { name: 'Byron', phone: '+234 800 000 0000' }
+};
+const course = { courseCode: 'cs101', courseName: 'Computing', credits: '3', schedule: { days: ['Mon', 'Wed'], time: '09:00' } };
+
+// The attendance route's checks before BODY_SCHEMAS
+const handWrittenAttendance = (body) => {
+  const { courseCode, faceData } = body;
+  if (!courseCode) return { error: 'Course code is required' };
+  if (!faceData || !Array.isArray(faceData) || !faceData.every(v => typeof v === 'number' && Number.isFinite(v))) {
+    return { error: 'Invalid or missing face data for verification' };
+  }
+  return { value: { courseCode: courseCode.toUpperCase(), faceData, location: body.location, notes: body.notes?.trim() } };
+};
+
+const validated = bodyValidators.attendance(attendance).value;
+assert.strictEqual(validated.courseCode, 'CS101');
+assert.strictEqual(validated.location.latitude, 6.5244);
+assert.strictEqual(validated.notes, 'arrived late');
+assert(!('extra' in validated));
+assert.strictEqual(bodyValidators.attendance({}).error, 'Course code is required');
+assert.strictEqual(bodyValidators.attendance({ courseCode: 'x', faceData: ['a'] }).error, 'Invalid or missing face data for verification');
+assert.notStrictEqual(bodyValidators.course({ ...course, credits: 'x' }).error, undefined);
+assert.deepStrictEqual(bodyValidators.student(student).value.enrolledCourses, ['CS101', 'MATH201']);
+
+const run = (label, fn) => {
+  for (let i = 0; i < WARMUP; i++) fn();
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < ITERATIONS; i++) fn();
+  const nsPerOp = Number(process.hrtime.bigint() - start) / ITERATIONS;
+  console.log(`${label.padEnd(36)} ${nsPerOp.toFixed(0).padStart(8)} ns/op`);
+};
+
+console.log(`${ITERATIONS} iterations (node ${process.version})`);
+run('attendance: hand-written checks', () => handWrittenAttendance(attendance));
+run('attendance: compiled validator', () => bodyValidators.attendance(attendance));
+run('attendance: missing courseCode', () => bodyValidators.attendance({ faceData: attendance.faceData }));
+run('student: compiled validator', () => bodyValidators.student(student));
+run('course: compiled validator', () => bodyValidators.course(course));
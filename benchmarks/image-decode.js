@@ -0,0 +1,65 @@
+// Face-image payload handling. Compares decoding a 3 MB data URL with decodeImagePayload against
+// the regex strip + Buffer.from it replaced, and building the Face++ request body as the former
+// urlencoded image_base64 form against the multipart form that now carries the raw bytes.
+// Also checks that decodeImagePayload still rejects malformed payloads.
+//
+//   node benchmarks/image-decode.js [imageMegabytes] [iterations]
+
+const assert = require('assert');
+const crypto = require('crypto');
+const { decodeImagePayload } = require('../server');
+
+const IMAGE_BYTES = (Number(process.argv[2]) || 3) * 1024 * 1024;
+const ITERATIONS = Number(process.argv[3]) || 30;
+
+const raw = crypto.randomBytes(IMAGE_BYTES);
+const base64 = raw.toString('base64');
+const dataUrl = `data:image/jpeg;base64,${base64}`;
+
+assert(decodeImagePayload(dataUrl).buffer.equals(raw));
+assert(decodeImagePayload(base64).buffer.equals(raw));
+assert.strictEqual(decodeImagePayload(`${base64.slice(0, -4)}@@@@`), null);
+assert.strictEqual(decodeImagePayload('data:text/plain;base64,AAAA'), null);
+assert.strictEqual(decodeImagePayload(''), null);
+
+const FIELDS = { api_key: 'benchmark-key', api_secret: 'benchmark-secret' };
+
+const urlencodedForm = () => {
+  const form = new URLSearchParams(FIELDS);
+  form.append('image_base64', base64);
+  return Buffer.from(form.toString());
+};
+
+const multipartForm = async (image) => {
+  const form = new FormData();
+  Object.entries(FIELDS).forEach(([name, value]) => form.append(name, value));
+  form.append('image_file', new Blob([image.buffer], { type: image.mimeType }), 'face.jpg');
+  return Buffer.from(await new Response(form).arrayBuffer());
+};
+
+const time = async (label, fn) => {
+  await fn();
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < ITERATIONS; i++) await fn();
+  const ms = Number(process.hrtime.bigint() - start) / ITERATIONS / 1e6;
+  console.log(`${label.padEnd(36)} ${ms.toFixed(2).padStart(8)} ms`);
+};
+
+const main = async () => {
+  console.log(`${(IMAGE_BYTES / 1024 / 1024).toFixed(1)} MB image, ${ITERATIONS} iterations (node ${process.version})`);
+  await time('decode: regex strip + Buffer.from', () => Buffer.from(dataUrl.replace(/^data:image\/[a-z]+;base64,/, ''), 'base64'));
+  await time('decode: decodeImagePayload', () => decodeImagePayload(dataUrl));
+
+  const image = decodeImagePayload(dataUrl);
+  await time('Face++ body: urlencoded image_base64', urlencodedForm);
+  await time('Face++ body: multipart image_file', () => multipartForm(image));
+
+  const urlencodedBytes = urlencodedForm().length;
+  const multipartBytes = (await multipartForm(image)).length;
+  console.log(`Face++ body size: urlencoded ${(urlencodedBytes / 1024 / 1024).toFixed(2)} MB, multipart ${(multipartBytes / 1024 / 1024).toFixed(2)} MB`);
+};
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
@@ -0,0 +1,11 @@
+// Render benchmarks need the app's jest-expo setup; run them with `npm run bench:lists`
+module.exports = {
+  rootDir: '..',
+  preset: 'jest-expo',
+  testMatch: ['<rootDir>/benchmarks/**/*.bench.js'],
+  setupFiles: ['<rootDir>/jest.setup.js'],
+  fakeTimers: {
+    enableGlobally: true,
+    doNotFake: ['performance', 'nextTick', 'setImmediate', 'queueMicrotask'],
+  },
+};
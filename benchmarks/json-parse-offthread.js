@@ -0,0 +1,96 @@
+// Event-loop stall from large face-image JSON bodies. The server runs in a child process twice:
+// once parsing every body inline (JSON_OFF_THREAD_MIN_BYTES raised past the body size) and once
+// with the worker pool. Each run posts ~4 MB base64 bodies to /api/student/attendance-image
+// (parsed, then refused by auth) while /api/health is probed every 10 ms, and reports the
+// server's p99/max event-loop delay and the probe latency.
+//
+//   node benchmarks/json-parse-offthread.js [uploads] [concurrency]
+
+const crypto = require('crypto');
+const { monitorEventLoopDelay } = require('perf_hooks');
+const {
+  forkServer,
+  serveForBenchmark,
+  request,
+  isServerRole,
+  percentile,
+  sendRequest,
+  formatMs
+} = require('./support');
+
+const UPLOADS = Number(process.argv[2]) || 40;
+const CONCURRENCY = Number(process.argv[3]) || 4;
+const IMAGE_BYTES = 3 * 1024 * 1024;
+const PROBE_INTERVAL_MS = 10;
+
+const runServer = () => {
+  const { app } = require('../server');
+  const delay = monitorEventLoopDelay({ resolution: 1 });
+  serveForBenchmark(require('http').createServer(app), (message) => {
+    if (message === 'start') {
+      delay.reset();
+      delay.enable();
+    } else if (message === 'stop') {
+      delay.disable();
+      process.send({ p99Ms: delay.percentile(99) / 1e6, maxMs: delay.max / 1e6 });
+    }
+  });
+};
+
+const sleep = (ms) => new Promise(resolve => setTimeout(resolve, ms));
+
+const measure = async (label, env, body) => {
+  const { child, port } = await forkServer(__filename, env);
+  const upload = () => sendRequest({
+    port,
+    method: 'POST',
+    path: '/api/student/attendance-image',
+    headers: { 'Content-Type': 'application/json', 'Content-Length': body.length },
+    body
+  });
+
+  await upload(); // warm up parsers and the worker pool
+  child.send('start');
+
+  let remaining = UPLOADS;
+  let done = false;
+  const probes = [];
+  const uploaders = Array.from({ length: CONCURRENCY }, async () => {
+    while (remaining-- > 0) await upload();
+  });
+  const prober = (async () => {
+    while (!done) {
+      probes.push((await sendRequest({ port, path: '/api/health' })).ms);
+      await sleep(PROBE_INTERVAL_MS);
+    }
+  })();
+
+  const start = performance.now();
+  await Promise.all(uploaders);
+  const totalMs = performance.now() - start;
+  done = true;
+  await prober;
+
+  const loop = await request(child, 'stop');
+  child.disconnect();
+  console.log(`${label.padEnd(12)} total ${formatMs(totalMs).padStart(10)}   event-loop p99 ${formatMs(loop.p99Ms).padStart(9)} max ${formatMs(loop.maxMs).padStart(9)}   health p50 ${formatMs(percentile(probes, 50)).padStart(9)} p99 ${formatMs(percentile(probes, 99)).padStart(9)}`);
+};
+
+const main = async () => {
+  const body = Buffer.from(JSON.stringify({
+    courseCode: 'CS101',
+    imageBase64: crypto.randomBytes(IMAGE_BYTES).toString('base64')
+  }));
+  console.log(`${UPLOADS} x ${(body.length / 1024 / 1024).toFixed(1)} MB JSON bodies, ${CONCURRENCY} at a time (node ${process.version})`);
+  await measure('inline', { JSON_OFF_THREAD_MIN_BYTES: String(Number.MAX_SAFE_INTEGER) }, body);
+  await measure('worker pool', {}, body);
+};
+
+if (isServerRole()) {
+  runServer();
+} else {
+  main().then(() => process.exit(0), (error) => {
+    console.error(error);
+    process.exit(1);
+  });
+}
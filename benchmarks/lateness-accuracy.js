@@ -0,0 +1,71 @@
+// Accuracy of the lateness percentiles served from t-digest sketches. Builds the per course/day
+// digests the way recordLatenessSample and compactLatenessDigest do (samples pushed as single
+// centroids, folded once LATENESS_DIGEST_MAX_UNMERGED pile up), merges them as the lateness
+// endpoint does, and compares p50/p90/p99 with the exact percentiles (linear interpolation over
+// the sorted samples). Lateness is skewed, in whole minutes between 16 and 240.
+//
+//   node benchmarks/lateness-accuracy.js [courses] [days]
+
+const { TDigest, LATENESS_DIGEST_COMPRESSION, LATENESS_DIGEST_MAX_UNMERGED } = require('../server');
+
+const COURSES = Number(process.argv[2]) || 4;
+const DAYS = Number(process.argv[3]) || 60;
+const SAMPLE_COUNTS = [1000, 20000, 200000];
+const QUANTILES = [0.5, 0.9, 0.99];
+
+let seed = 42;
+const random = () => {
+  seed = (seed * 1103515245 + 12345) % 2147483648;
+  return seed / 2147483648;
+};
+const lateMinutes = () => Math.min(240, 16 + Math.floor(Math.exp(2.5 + random() + random())));
+
+const exactQuantile = (sorted, q) => {
+  const position = q * (sorted.length - 1);
+  const low = Math.floor(position);
+  const high = Math.ceil(position);
+  return sorted[low] + (sorted[high] - sorted[low]) * (position - low);
+};
+
+// One stored LatenessDigest document, updated as the server updates it
+const storedDigest = () => ({ centroids: [], unmerged: 0, min: Infinity, max: -Infinity });
+
+const pushSample = (doc, minutes) => {
+  doc.centroids.push({ mean: minutes, count: 1 });
+  doc.unmerged++;
+  doc.min = Math.min(doc.min, minutes);
+  doc.max = Math.max(doc.max, minutes);
+  if (doc.unmerged >= LATENESS_DIGEST_MAX_UNMERGED) {
+    const digest = new TDigest(LATENESS_DIGEST_COMPRESSION);
+    digest.merge(doc.centroids);
+    digest.compress();
+    doc.centroids = digest.centroids;
+    doc.unmerged = 0;
+  }
+};
+
+const signed = (value) => `${value >= 0 ? '+' : ''}${value.toFixed(1)}`;
+
+console.log(`${COURSES} courses x ${DAYS} days, compression ${LATENESS_DIGEST_COMPRESSION} (node ${process.version})`);
+for (const total of SAMPLE_COUNTS) {
+  const samples = [];
+  const docs = Array.from({ length: COURSES * DAYS }, storedDigest);
+  docs.forEach((doc, index) => {
+    const share = Math.floor((index + 1) * total / docs.length) - Math.floor(index * total / docs.length);
+    for (let i = 0; i < share; i++) {
+      const minutes = lateMinutes();
+      samples.push(minutes);
+      pushSample(doc, minutes);
+    }
+  });
+
+  const merged = new TDigest(LATENESS_DIGEST_COMPRESSION);
+  docs.forEach(doc => merged.merge(doc.centroids, doc.min, doc.max));
+  samples.sort((a, b) => a - b);
+
+  const errors = QUANTILES.map((q) => {
+    const exact = exactQuantile(samples, q);
+    return `p${Math.round(q * 100)} ${exact.toFixed(1)} ${signed(merged.quantile(q) - exact)} min`;
+  });
+  console.log(`${String(samples.length).padStart(7)} samples: ${errors.join('  ')}  (${merged.centroids.length} centroids)`);
+}
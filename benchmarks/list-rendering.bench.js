@@ -0,0 +1,61 @@
+import React from 'react';
+import renderer, { act } from 'react-test-renderer';
+import { StudentList, AttendanceHistoryList } from '../App';
+import { makeStudents, makeAttendanceRecords } from '../__tests__/app/fixtures';
+
+// Headless render timings for the virtualized lists: median time to mount each list and to
+// re-render it with unchanged data (memoized rows should skip), for 10, 1,000 and 10,000 records.
+//
+//   npm run bench:lists
+const SIZES = [10, 1000, 10000];
+const RUNS = 5;
+
+const noop = () => {};
+const LISTS = [
+  {
+    name: 'StudentList',
+    fixture: makeStudents,
+    render: (data) => <StudentList students={data} loading={false} onRefresh={noop} onDelete={noop} />,
+  },
+  {
+    name: 'AttendanceHistoryList',
+    fixture: makeAttendanceRecords,
+    render: (data) => <AttendanceHistoryList records={data} loading={false} onRefresh={noop} />,
+  },
+];
+
+const median = (values) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.floor(sorted.length / 2)];
+};
+
+const timed = (fn) => {
+  const start = performance.now();
+  fn();
+  return performance.now() - start;
+};
+
+test('list render timings', () => {
+  const lines = [];
+  for (const list of LISTS) {
+    for (const size of SIZES) {
+      const data = list.fixture(size);
+      const mountTimes = [];
+      const updateTimes = [];
+
+      for (let run = 0; run < RUNS; run++) {
+        let tree;
+        mountTimes.push(timed(() => act(() => {
+          tree = renderer.create(list.render(data));
+        })));
+        updateTimes.push(timed(() => act(() => {
+          tree.update(list.render(data));
+        })));
+        act(() => tree.unmount());
+      }
+
+      lines.push(`${list.name}/${size}: mount ${median(mountTimes).toFixed(2)} ms, update ${median(updateTimes).toFixed(2)} ms`);
+    }
+  }
+  console.log(lines.join('\n'));
+}, 5 * 60 * 1000);
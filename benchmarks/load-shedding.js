@@ -0,0 +1,98 @@
+// Goodput under overload with and without shedUnderOverload. A child process serves three routes
+// that stand in for attendance (critical), materials (normal) and analytics (low priority); each
+// waits 20 ms (the database) and then burns 6 ms of CPU. An open-loop client sends a 30/40/30 mix
+// at a fixed rate with a 1 s timeout, and counts responses that arrived in time, were shed with
+// 503, arrived late or failed. Run it pinned to one core (e.g. taskset -c 0) to match the
+// numbers in the README. OVERLOAD_LAG_MS and OVERLOAD_MAX_IN_FLIGHT default to 100 and 40 here.
+//
+//   node benchmarks/load-shedding.js [requestsPerSecond] [seconds]
+
+const http = require('http');
+const { forkServer, serveForBenchmark, isServerRole, sendRequest } = require('./support');
+
+const RATE = Number(process.argv[2]) || 450;
+const DURATION_MS = (Number(process.argv[3]) || 6) * 1000;
+const TIMEOUT_MS = 1000;
+const HANDLER_WAIT_MS = 20;
+const HANDLER_CPU_MS = 6;
+const TICK_MS = 10;
+const MIX = [
+  { path: '/api/student/attendance', share: 0.3 },
+  { path: '/api/student/materials', share: 0.4 },
+  { path: '/api/admin/analytics', share: 0.3 }
+];
+
+const runServer = () => {
+  const express = require('express');
+  const { shedUnderOverload } = require('../server');
+  const app = express();
+  if (process.env.BENCH_SHED === '1') app.use(shedUnderOverload);
+  app.get(MIX.map(entry => entry.path), (req, res) => {
+    setTimeout(() => {
+      const end = performance.now() + HANDLER_CPU_MS;
+      while (performance.now() < end);
+      res.json({ success: true });
+    }, HANDLER_WAIT_MS);
+  });
+  serveForBenchmark(http.createServer(app));
+};
+
+const pickPath = () => {
+  let r = Math.random();
+  for (const entry of MIX) {
+    if ((r -= entry.share) < 0) return entry.path;
+  }
+  return MIX[MIX.length - 1].path;
+};
+
+const measure = async (label, shed) => {
+  const { child, port } = await forkServer(__filename, {
+    BENCH_SHED: shed ? '1' : '0',
+    OVERLOAD_LAG_MS: process.env.OVERLOAD_LAG_MS || '100',
+    OVERLOAD_MAX_IN_FLIGHT: process.env.OVERLOAD_MAX_IN_FLIGHT || '40'
+  });
+  const stats = Object.fromEntries(MIX.map(({ path }) => [path, { ok: 0, shed: 0, late: 0, failed: 0 }]));
+  const pending = [];
+  const perTick = RATE * TICK_MS / 1000;
+  let owed = 0;
+
+  const start = performance.now();
+  await new Promise((resolve) => {
+    const timer = setInterval(() => {
+      if (performance.now() - start >= DURATION_MS) {
+        clearInterval(timer);
+        return resolve();
+      }
+      for (owed += perTick; owed >= 1; owed--) {
+        const path = pickPath();
+        pending.push(sendRequest({ port, path, timeout: TIMEOUT_MS }).then(({ status, ms }) => {
+          const outcome = status === 503 ? 'shed' : status === 0 ? 'failed' : ms > TIMEOUT_MS ? 'late' : 'ok';
+          stats[path][outcome]++;
+        }));
+      }
+    }, TICK_MS);
+  });
+  await Promise.all(pending);
+  child.disconnect();
+
+  const ok = Object.values(stats).reduce((total, entry) => total + entry.ok, 0);
+  console.log(`${label}: ${pending.length} sent, goodput ${(ok / (DURATION_MS / 1000)).toFixed(0)}/s`);
+  for (const [path, entry] of Object.entries(stats)) {
+    console.log(`  ${path.padEnd(26)} ok ${String(entry.ok).padStart(5)}  shed ${String(entry.shed).padStart(5)}  late ${String(entry.late).padStart(5)}  failed ${String(entry.failed).padStart(5)}`);
+  }
+};
+
+const main = async () => {
+  console.log(`${RATE} req/s for ${DURATION_MS / 1000} s, ${TIMEOUT_MS} ms timeout (node ${process.version})`);
+  await measure('without shedding', false);
+  await measure('with shedding', true);
+};
+
+if (isServerRole()) {
+  runServer();
+} else {
+  main().then(() => process.exit(0), (error) => {
+    console.error(error);
+    process.exit(1);
+  });
+}
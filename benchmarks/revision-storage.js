@@ -0,0 +1,219 @@
+// Storage and transfer for material revisions in the content-defined chunk store. Generates three
+// synthetic 8-revision series that mimic weekly edits: a slide deck (.pptx: deflated slide XML,
+// stored media), a document (.docx: one deflated body plus images) and a PDF (one Flate stream per
+// page, images, cross-reference table at the end). Each version is split with the server's
+// cdcChunks; the script reports how much the store keeps, how much each revision uploads, and
+// what fixed 1 MB chunks would have uploaded instead. Output is deterministic for a given seed.
+//
+//   node benchmarks/revision-storage.js [seed]
+
+const crypto = require('crypto');
+const zlib = require('zlib');
+const { Readable } = require('stream');
+const { cdcChunks } = require('../server');
+
+const SEED = Number(process.argv[2]) || 7;
+const REVISIONS = 8;
+const FIXED_CHUNK_SIZE = 1024 * 1024;
+
+// mulberry32, so every run produces the same series
+let state = SEED;
+const random = () => {
+  state = (state + 0x6d2b79f5) | 0;
+  let t = Math.imul(state ^ (state >>> 15), state | 1);
+  t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+  return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+};
+const randomInt = (min, max) => min + Math.floor(random() * (max - min + 1));
+const randomIndex = (length) => Math.floor(random() * length);
+const randomBytes = (length) => {
+  const bytes = Buffer.alloc(length);
+  for (let i = 0; i < length; i += 4) bytes.writeUInt32LE((random() * 4294967296) >>> 0, Math.min(i, length - 4));
+  return bytes;
+};
+
+const WORDS = ('lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor incididunt ut ' +
+  'labore et dolore magna aliqua network protocol packet routing latency throughput subnet switch ' +
+  'vlan tcp udp frame header checksum window congestion handshake socket datagram').split(' ');
+const paragraph = (words) => Array.from({ length: words }, () => WORDS[randomIndex(WORDS.length)]).join(' ');
+
+// Minimal zip writer (no data descriptors, fixed timestamps), enough for Office containers
+const CRC_TABLE = Int32Array.from({ length: 256 }, (_, n) => {
+  let c = n;
+  for (let k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+  return c;
+});
+const crc32 = (bytes) => {
+  let crc = -1;
+  for (let i = 0; i < bytes.length; i++) crc = CRC_TABLE[(crc ^ bytes[i]) & 0xff] ^ (crc >>> 8);
+  return (crc ^ -1) >>> 0;
+};
+
+const zip = (entries) => {
+  const parts = [];
+  const central = [];
+  let offset = 0;
+  for (const { name, data, deflate } of entries) {
+    const body = deflate ? zlib.deflateRawSync(data) : data;
+    const fileName = Buffer.from(name);
+    const header = Buffer.alloc(30);
+    header.writeUInt32LE(0x04034b50, 0);
+    header.writeUInt16LE(20, 4);
+    header.writeUInt16LE(deflate ? 8 : 0, 8);
+    header.writeUInt16LE(0x2821, 12); // 2024-01-01
+    header.writeUInt32LE(crc32(data), 14);
+    header.writeUInt32LE(body.length, 18);
+    header.writeUInt32LE(data.length, 22);
+    header.writeUInt16LE(fileName.length, 26);
+    const record = Buffer.alloc(46);
+    record.writeUInt32LE(0x02014b50, 0);
+    record.writeUInt16LE(20, 4);
+    record.writeUInt16LE(20, 6);
+    header.copy(record, 8, 6, 30);
+    record.writeUInt32LE(offset, 42);
+    central.push(record, fileName);
+    parts.push(header, fileName, body);
+    offset += header.length + fileName.length + body.length;
+  }
+  const centralDirectory = Buffer.concat(central);
+  const end = Buffer.alloc(22);
+  end.writeUInt32LE(0x06054b50, 0);
+  end.writeUInt16LE(entries.length, 8);
+  end.writeUInt16LE(entries.length, 10);
+  end.writeUInt32LE(centralDirectory.length, 12);
+  end.writeUInt32LE(offset, 16);
+  return Buffer.concat([...parts, centralDirectory, end]);
+};
+
+const slideDeckSeries = () => {
+  const slides = Array.from({ length: 40 }, () => Array.from({ length: randomInt(3, 8) }, () => paragraph(randomInt(10, 40))));
+  const media = Array.from({ length: 15 }, () => randomBytes(randomInt(150000, 900000)));
+  const build = () => zip([
+    { name: '[Content_Types].xml', data: Buffer.from('<Types/>'.repeat(50)), deflate: true },
+    ...slides.map((texts, i) => ({
+      name: `ppt/slides/slide${i + 1}.xml`,
+      data: Buffer.from(`<p:sld><p:cSld><p:spTree>${texts.map(t => `<a:p><a:r><a:t>${t}</a:t></a:r></a:p>`).join('')}</p:spTree></p:cSld></p:sld>`),
+      deflate: true
+    })),
+    ...media.map((data, i) => ({ name: `ppt/media/image${i + 1}.png`, data, deflate: false }))
+  ]);
+  const versions = [build()];
+  for (let revision = 2; revision <= REVISIONS; revision++) {
+    for (let edits = randomInt(1, 3); edits > 0; edits--) {
+      const slide = slides[randomIndex(slides.length)];
+      slide[randomIndex(slide.length)] = paragraph(randomInt(10, 40));
+    }
+    if (revision % 3 === 0) slides.splice(randomIndex(slides.length), 0, Array.from({ length: 4 }, () => paragraph(20)));
+    if (revision % 4 === 0) media.splice(randomIndex(media.length), 0, randomBytes(400000));
+    if (revision === 7) slides.splice(5, 1);
+    versions.push(build());
+  }
+  return versions;
+};
+
+const documentSeries = () => {
+  const paragraphs = Array.from({ length: 900 }, () => paragraph(randomInt(30, 120)));
+  const media = Array.from({ length: 6 }, () => randomBytes(randomInt(100000, 500000)));
+  const build = () => zip([
+    {
+      name: 'word/document.xml',
+      data: Buffer.from(`<w:document><w:body>${paragraphs.map(p => `<w:p><w:r><w:t>${p}</w:t></w:r></w:p>`).join('')}</w:body></w:document>`),
+      deflate: true
+    },
+    ...media.map((data, i) => ({ name: `word/media/image${i}.jpeg`, data, deflate: false }))
+  ]);
+  const versions = [build()];
+  for (let revision = 2; revision <= REVISIONS; revision++) {
+    for (let edits = randomInt(2, 6); edits > 0; edits--) paragraphs[randomIndex(paragraphs.length)] = paragraph(randomInt(30, 120));
+    paragraphs.splice(randomIndex(paragraphs.length), 0, paragraph(60));
+    versions.push(build());
+  }
+  return versions;
+};
+
+const pdfSeries = () => {
+  const pages = Array.from({ length: 60 }, () => Array.from({ length: 5 }, () => paragraph(randomInt(40, 200))));
+  const images = Array.from({ length: 10 }, () => randomBytes(randomInt(80000, 300000)));
+  const build = () => {
+    const parts = [Buffer.from('%PDF-1.7\n')];
+    const offsets = [];
+    let length = parts[0].length;
+    const object = (dictionary, data) => {
+      offsets.push(length);
+      const part = Buffer.concat([
+        Buffer.from(`${offsets.length} 0 obj<<${dictionary}/Length ${data.length}>>stream\n`),
+        data,
+        Buffer.from('\nendstream endobj\n')
+      ]);
+      parts.push(part);
+      length += part.length;
+    };
+    pages.forEach(lines => object('/Filter/FlateDecode', zlib.deflateSync(Buffer.from(`BT ${lines.map(t => `(${t}) Tj`).join(' ')} ET`))));
+    images.forEach(data => object('/Subtype/Image', data));
+    parts.push(Buffer.from(`xref\n${offsets.map(o => `${String(o).padStart(10, '0')} 00000 n \n`).join('')}trailer\n%%EOF\n`));
+    return Buffer.concat(parts);
+  };
+  const versions = [build()];
+  for (let revision = 2; revision <= REVISIONS; revision++) {
+    for (let edits = randomInt(1, 3); edits > 0; edits--) pages[randomIndex(pages.length)][randomIndex(5)] = paragraph(randomInt(40, 200));
+    if (revision % 2 === 0) pages.splice(randomIndex(pages.length), 0, Array.from({ length: 5 }, () => paragraph(80)));
+    versions.push(build());
+  }
+  return versions;
+};
+
+const sha256 = (bytes) => crypto.createHash('sha256').update(bytes).digest('hex');
+
+const cdcSplit = async (buffer) => {
+  const chunks = [];
+  for await (const chunk of cdcChunks(Readable.from([buffer]))) chunks.push(chunk);
+  return chunks;
+};
+
+const fixedSplit = (buffer) => {
+  const chunks = [];
+  for (let offset = 0; offset < buffer.length; offset += FIXED_CHUNK_SIZE) chunks.push(buffer.subarray(offset, offset + FIXED_CHUNK_SIZE));
+  return chunks;
+};
+
+// Bytes each version adds to a store that already holds the previous versions
+const newBytesPerVersion = async (versions, split) => {
+  const stored = new Set();
+  const added = [];
+  for (const version of versions) {
+    let bytes = 0;
+    for (const chunk of await split(version)) {
+      const hash = sha256(chunk);
+      if (!stored.has(hash)) {
+        stored.add(hash);
+        bytes += chunk.length;
+      }
+    }
+    added.push(bytes);
+  }
+  return added;
+};
+
+const MB = (bytes) => (bytes / 1e6).toFixed(1);
+const percent = (part, whole) => `${(100 * part / whole).toFixed(1)}%`;
+const sum = (values) => values.reduce((total, value) => total + value, 0);
+
+const main = async () => {
+  console.log(`${REVISIONS} revisions per series, seed ${SEED} (node ${process.version})`);
+  for (const [label, series] of [['slide deck (.pptx)', slideDeckSeries], ['document (.docx)', documentSeries], ['PDF', pdfSeries]]) {
+    const versions = series();
+    const sizes = versions.map(version => version.length);
+    const cdc = await newBytesPerVersion(versions, cdcSplit);
+    const fixed = await newBytesPerVersion(versions, fixedSplit);
+    const total = sum(sizes);
+    const revisionBytes = sum(sizes.slice(1));
+    console.log(`${label}: ${MB(Math.min(...sizes))}-${MB(Math.max(...sizes))} MB per version`);
+    console.log(`  stored ${MB(sum(cdc))} of ${MB(total)} MB (-${percent(total - sum(cdc), total)})`);
+    console.log(`  revision upload: content-defined ${percent(sum(cdc.slice(1)), revisionBytes)}, fixed 1 MB ${percent(sum(fixed.slice(1)), revisionBytes)} of the full files`);
+  }
+};
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
@@ -0,0 +1,61 @@
+// Shared helpers for the benchmark scripts
+const http = require('http');
+const { fork } = require('child_process');
+
+// Runs `file` again as a child with BENCH_ROLE=server and the given environment. The child calls
+// serveForBenchmark() with its HTTP server; resolves once it is listening.
+const forkServer = (file, env = {}) => new Promise((resolve, reject) => {
+  const child = fork(file, process.argv.slice(2), {
+    env: { ...process.env, ...env, BENCH_ROLE: 'server', TRACING: 'off' },
+    stdio: ['ignore', 'ignore', 'inherit', 'ipc']
+  });
+  child.once('message', ({ port }) => resolve({ child, port }));
+  child.once('exit', (code) => reject(new Error(`benchmark server exited with code ${code}`)));
+});
+
+const serveForBenchmark = (server, onMessage = () => {}) => {
+  server.listen(0, '127.0.0.1', () => process.send({ port: server.address().port }));
+  process.on('message', onMessage);
+  process.on('disconnect', () => process.exit(0));
+};
+
+// Ask the child for a value and wait for its reply
+const request = (child, message) => new Promise((resolve) => {
+  child.once('message', resolve);
+  child.send(message);
+});
+
+const isServerRole = () => process.env.BENCH_ROLE === 'server';
+
+const percentile = (values, p) => {
+  if (values.length === 0) return NaN;
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p / 100))];
+};
+
+const agent = new http.Agent({ keepAlive: true, maxSockets: 2000 });
+
+// Resolves with the status code and elapsed milliseconds; network errors and timeouts resolve
+// with status 0 so load generators can count them without try/catch
+const sendRequest = ({ port, method = 'GET', path, headers = {}, body, timeout = 0 }) => new Promise((resolve) => {
+  const start = performance.now();
+  const req = http.request({ host: '127.0.0.1', port, method, path, headers, agent, timeout }, (res) => {
+    res.resume();
+    res.on('end', () => resolve({ status: res.statusCode, ms: performance.now() - start }));
+  });
+  req.on('timeout', () => req.destroy());
+  req.on('error', () => resolve({ status: 0, ms: performance.now() - start }));
+  req.end(body);
+});
+
+const formatMs = (ms) => `${ms.toFixed(1)} ms`;
+
+module.exports = {
+  forkServer,
+  serveForBenchmark,
+  request,
+  isServerRole,
+  percentile,
+  sendRequest,
+  formatMs
+};
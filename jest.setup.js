@@ -0,0 +1,45 @@
+// Native modules App.js imports at load time. jest-expo stubs the core Expo modules; these
+// are replaced here so the app module can be imported in the test renderer.
+require('react-native-gesture-handler/jestSetup');
+
+jest.mock('@react-native-async-storage/async-storage', () =>
+  require('@react-native-async-storage/async-storage/jest/async-storage-mock')
+);
+
+jest.mock('expo-file-system', () => ({
+  documentDirectory: 'file:///documents/',
+  cacheDirectory: 'file:///cache/',
+  getInfoAsync: jest.fn(async () => ({ exists: false })),
+  makeDirectoryAsync: jest.fn(async () => {}),
+  downloadAsync: jest.fn(async () => ({ status: 404 })),
+  deleteAsync: jest.fn(async () => {}),
+}));
+
+jest.mock('expo-crypto', () => ({
+  CryptoDigestAlgorithm: { SHA1: 'SHA-1', SHA256: 'SHA-256' },
+  digestStringAsync: jest.fn(async (algorithm, value) => value),
+}));
+
+jest.mock('expo-camera', () => ({
+  CameraView: 'CameraView',
+  useCameraPermissions: jest.fn(() => [null, jest.fn()]),
+}));
+
+jest.mock('expo-video', () => ({
+  VideoView: 'VideoView',
+  useVideoPlayer: jest.fn(() => ({})),
+}));
+
+jest.mock('expo-network', () => ({
+  NetworkStateType: { WIFI: 'WIFI', CELLULAR: 'CELLULAR' },
+  getNetworkStateAsync: jest.fn(async () => ({ isConnected: true, type: 'WIFI' })),
+}));
+
+jest.mock('expo-image-manipulator', () => ({
+  SaveFormat: { JPEG: 'jpeg' },
+  manipulateAsync: jest.fn(),
+}));
+
+jest.mock('expo-sqlite', () => ({
+  openDatabaseAsync: jest.fn(),
+}));
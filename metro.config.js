@@ -0,0 +1,9 @@
+// Learn more https://docs.expo.dev/guides/customizing-metro
+const { getDefaultConfig } = require('expo/metro-config');
+
+const config = getDefaultConfig(__dirname);
+
+// expo-sqlite's web build loads SQLite as a WebAssembly asset
+config.resolver.assetExts.push('wasm');
+
+module.exports = config;
@@ -0,0 +1,258 @@
+import React, { useState, useEffect } from 'react';
+import {
+  View,
+  Text,
+  ScrollView,
+  SafeAreaView,
+  Dimensions,
+} from 'react-native';
+import { Picker } from '@react-native-picker/picker';
+import { apiCall, showError, pad2, EMPTY_LIST, styles } from '../App';
+
+// Attendance reports, split from App.js so the web console loads it only when the screen is opened
+const { width } = Dimensions.get('window');
+
+// Weekday × hour heatmap chart
+const WEEKDAY_LABELS = ['Sun', 'Mon', 'Tue', 'Wed', 'Thu', 'Fri', 'Sat'];
+
+const heatmapColor = (rate) => {
+  // Red (0%) through amber to green (100%)
+  const hue = Math.round(Math.max(0, Math.min(100, rate)) * 1.2);
+  return `hsl(${hue}, 70%, 50%)`;
+};
+
+const AttendanceHeatmapChart = React.memo(({ cells }) => {
+  if (cells.length === 0) {
+    return <Text style={styles.emptySubtext}>No attendance recorded yet</Text>;
+  }
+
+  const hours = [...new Set(cells.map(cell => cell.hour))].sort((a, b) => a - b);
+  const weekdays = [...new Set(cells.map(cell => cell.weekday))].sort((a, b) => a - b);
+  const cellByKey = {};
+  cells.forEach(cell => { cellByKey[`${cell.weekday}-${cell.hour}`] = cell; });
+
+  return (
+    <ScrollView horizontal showsHorizontalScrollIndicator={false}>
+      <View>
+        <View style={styles.heatmapRow}>
+          <View style={styles.heatmapRowLabel} />
+          {hours.map(hour => (
+            <Text key={hour} style={styles.heatmapHourLabel}>{pad2(hour)}</Text>
+          ))}
+        </View>
+        {weekdays.map(weekday => (
+          <View key={weekday} style={styles.heatmapRow}>
+            <Text style={styles.heatmapRowLabel}>{WEEKDAY_LABELS[weekday]}</Text>
+            {hours.map(hour => {
+              const cell = cellByKey[`${weekday}-${hour}`];
+              return (
+                <View
+                  key={hour}
+                  style={[
+                    styles.heatmapCell,
+                    cell ? { backgroundColor: heatmapColor(cell.attendanceRate) } : styles.heatmapCellEmpty
+                  ]}
+                >
+                  {cell && <Text style={styles.heatmapCellText}>{cell.attendanceRate.toFixed(0)}</Text>}
+                </View>
+              );
+            })}
+          </View>
+        ))}
+      </View>
+    </ScrollView>
+  );
+});
+
+// Daily attendance rate as bars; the server decimates the series to one bar per few pixels of width
+const TREND_DAYS = 180;
+const TREND_BAR_PITCH = 4;
+const TREND_POINTS = Math.floor((width - 72) / TREND_BAR_PITCH);
+
+const AttendanceTrendChart = React.memo(({ days }) => {
+  if (days.length === 0) {
+    return <Text style={styles.emptySubtext}>No attendance recorded yet</Text>;
+  }
+
+  const formatDay = (day) => new Date(day._id).toLocaleDateString('en', { month: 'short', day: 'numeric' });
+
+  return (
+    <View>
+      <View style={styles.trendChart}>
+        {days.map(day => (
+          <View
+            key={day._id}
+            accessibilityLabel={`${formatDay(day)}: ${day.attendanceRate.toFixed(0)}% of ${day.enrolled} enrolled`}
+            style={[
+              styles.trendBar,
+              { height: `${Math.max(day.attendanceRate, 2)}%`, backgroundColor: heatmapColor(day.attendanceRate) }
+            ]}
+          />
+        ))}
+      </View>
+      <View style={styles.trendAxis}>
+        <Text style={styles.trendAxisLabel}>{formatDay(days[0])}</Text>
+        <Text style={styles.trendAxisLabel}>{formatDay(days[days.length - 1])}</Text>
+      </View>
+    </View>
+  );
+});
+
+// Attendance Reports Screen
+const AttendanceReportsScreen = ({ navigation }) => {
+  const [reports, setReports] = useState({});
+  const [loading, setLoading] = useState(false);
+  const [selectedCourse, setSelectedCourse] = useState('');
+  const [courses, setCourses] = useState([]);
+  const [heatmap, setHeatmap] = useState({ cells: [] });
+
+  useEffect(() => {
+    loadCourses();
+  }, []);
+
+  useEffect(() => {
+    loadReports();
+    loadHeatmap();
+  }, [selectedCourse]);
+
+  const loadCourses = async () => {
+    try {
+      const response = await apiCall('/admin/courses');
+      if (response.success) {
+        setCourses(response.data || []);
+      }
+    } catch (error) {
+      console.error('Failed to load courses:', error);
+    }
+  };
+
+  const loadReports = async () => {
+    setLoading(true);
+    try {
+      let params = `?trendDays=${TREND_DAYS}&points=${TREND_POINTS}`;
+      if (selectedCourse) params += `&courseCode=${selectedCourse}`;
+      
+      const response = await apiCall(`/admin/analytics${params}`);
+      if (response.success) {
+        setReports(response.data);
+      }
+    } catch (error) {
+      showError('Failed to load reports');
+    } finally {
+      setLoading(false);
+    }
+  };
+
+  const loadHeatmap = async () => {
+    try {
+      const params = selectedCourse ? `?courseCode=${selectedCourse}` : '';
+      const response = await apiCall(`/admin/analytics/heatmap${params}`);
+      if (response.success) {
+        setHeatmap(response.data);
+      }
+    } catch (error) {
+      console.error('Failed to load heatmap:', error);
+    }
+  };
+
+  return (
+    <SafeAreaView style={styles.container}>
+      <View style={styles.reportsHeader}>
+        <Text style={styles.reportsTitle}>Attendance Reports</Text>
+        <Text style={styles.reportsSubtitle}>Analytics and insights</Text>
+      </View>
+
+      <View style={styles.filterSection}>
+        <Text style={styles.filterLabel}>Filter by Course:</Text>
+        <View style={styles.pickerWrapper}>
+          <Picker
+            selectedValue={selectedCourse}
+            style={styles.coursePicker}
+            onValueChange={setSelectedCourse}
+          >
+            <Picker.Item label="All Courses" value="" />
+            {courses.map(course => (
+              <Picker.Item
+                key={course.courseCode}
+                label={`${course.courseCode} - ${course.courseName}`}
+                value={course.courseCode}
+              />
+            ))}
+          </Picker>
+        </View>
+      </View>
+
+      <ScrollView style={styles.reportsContainer}>
+        <View style={styles.reportCard}>
+          <Text style={styles.reportCardTitle}>Overview Statistics</Text>
+          <View style={styles.reportMetrics}>
+            <View style={styles.reportMetric}>
+              <Text style={styles.reportMetricValue}>{reports.overview?.totalStudents || 0}</Text>
+              <Text style={styles.reportMetricLabel}>Students</Text>
+            </View>
+            <View style={styles.reportMetric}>
+              <Text style={styles.reportMetricValue}>{reports.overview?.overallAttendanceRate || 0}%</Text>
+              <Text style={styles.reportMetricLabel}>Attendance Rate</Text>
+            </View>
+            <View style={styles.reportMetric}>
+              <Text style={styles.reportMetricValue}>{reports.overview?.totalAttendanceRecords || 0}</Text>
+              <Text style={styles.reportMetricLabel}>Total Records</Text>
+            </View>
+          </View>
+        </View>
+
+        <View style={styles.reportCard}>
+          <Text style={styles.reportCardTitle}>Course Performance</Text>
+          {reports.coursePerformance?.map((course, index) => (
+            <View key={index} style={styles.coursePerformanceItem}>
+              <View style={styles.coursePerformanceHeader}>
+                <Text style={styles.courseCode}>{course.courseCode}</Text>
+                <Text style={styles.courseAttendanceRate}>{course.attendanceRate?.toFixed(1) || 0}%</Text>
+              </View>
+              <View style={styles.courseProgressBar}>
+                <View 
+                  style={[
+                    styles.progressFill,
+                    { width: `${course.attendanceRate || 0}%` }
+                  ]}
+                />
+              </View>
+            </View>
+          ))}
+        </View>
+
+        <View style={styles.reportCard}>
+          <Text style={styles.reportCardTitle}>Top Performing Students</Text>
+          {reports.topStudents?.map((student, index) => (
+            <View key={index} style={styles.topStudentItem}>
+              <Text style={styles.topStudentRank}>{index + 1}</Text>
+              <View style={styles.topStudentInfo}>
+                <Text style={styles.topStudentName}>{student.studentName}</Text>
+                <Text style={styles.topStudentId}>{student.studentId}</Text>
+              </View>
+              <Text style={styles.topStudentRate}>{student.attendanceRate?.toFixed(1) || 0}%</Text>
+            </View>
+          ))}
+        </View>
+
+        <View style={styles.reportCard}>
+          <Text style={styles.reportCardTitle}>Attendance Trend ({TREND_DAYS} days)</Text>
+          <AttendanceTrendChart days={reports.dailyTrend || EMPTY_LIST} />
+        </View>
+
+        <View style={styles.reportCard}>
+          <Text style={styles.reportCardTitle}>Turnout by Day & Hour</Text>
+          <AttendanceHeatmapChart cells={heatmap.cells || EMPTY_LIST} />
+          {heatmap.worstSlot && (
+            <Text style={styles.heatmapCaption}>
+              Lowest turnout: {WEEKDAY_LABELS[heatmap.worstSlot.weekday]} {pad2(heatmap.worstSlot.hour)}:00
+              {' '}({heatmap.worstSlot.attendanceRate.toFixed(0)}% of {heatmap.worstSlot.total} expected)
+            </Text>
+          )}
+        </View>
+      </ScrollView>
+    </SafeAreaView>
+  );
+};
+
+export default AttendanceReportsScreen;
@@ -7,44 +7,92 @@ const cors = require('cors');
 const path = require('path');
 const fs = require('fs');
 const axios = require('axios');
+const crypto = require('crypto');
+const zlib = require('zlib');
+const util = require('util');
+const { Readable } = require('stream');
+const { pipeline } = require('stream/promises');
+const { execFile } = require('child_process');
+const { Worker } = require('worker_threads');
+const { AsyncLocalStorage } = require('async_hooks');
+const { monitorEventLoopDelay } = require('perf_hooks');
+const os = require('os');
 require('dotenv').config();
 
+const inflateAsync = util.promisify(zlib.inflate);
+const inflateRawAsync = util.promisify(zlib.inflateRaw);
+const execFileAsync = util.promisify(execFile);
+
 // Face++ API config
 const FACEPP_API_KEY = process.env.FACEPP_API_KEY || '';
 const FACEPP_API_SECRET = process.env.FACEPP_API_SECRET || '';
 const FACEPP_DETECT_URL = 'https://api-us.faceplusplus.com/facepp/v3/detect';
 const FACEPP_COMPARE_URL = 'https://api-us.faceplusplus.com/facepp/v3/compare';
 
-async function faceppDetectGetToken(imageBase64) {
+// Image payloads arrive as base64, optionally as a data URL. The prefix is found by looking at the
+// first few characters only, and the rest is decoded once into a Buffer. Face++ gets the bytes as
+// multipart image_file instead of a percent-encoded base64 form field.
+const DATA_URL_PREFIX_MAX_LENGTH = 64;
+const DATA_URL_BASE64_MARKER = ';base64,';
+
+const splitImageDataUrl = (value) => {
+  if (typeof value !== 'string' || value.length === 0) return null;
+  if (!value.startsWith('data:')) {
+    return { mimeType: 'image/jpeg', base64: value };
+  }
+  const marker = value.indexOf(DATA_URL_BASE64_MARKER, 5);
+  if (marker === -1 || marker > DATA_URL_PREFIX_MAX_LENGTH) return null;
+  const mimeType = value.slice(5, marker);
+  if (!mimeType.startsWith('image/')) return null;
+  return { mimeType, base64: value.slice(marker + DATA_URL_BASE64_MARKER.length) };
+};
+
+// Buffer.from skips characters outside the base64 alphabet, so a decoded length that differs from
+// the one implied by the input length means the payload was not clean base64
+const decodeImagePayload = (value) => {
+  const parts = splitImageDataUrl(value);
+  if (!parts) return null;
+  const { base64 } = parts;
+  let dataLength = base64.length;
+  while (dataLength > 0 && base64.charCodeAt(dataLength - 1) === 61 /* = */ && base64.length - dataLength < 2) {
+    dataLength--;
+  }
+  if (dataLength === 0 || dataLength % 4 === 1) return null;
+
+  const buffer = Buffer.from(base64, 'base64');
+  if (buffer.length !== Math.floor(dataLength * 3 / 4)) return null;
+  return { mimeType: parts.mimeType, buffer };
+};
+
+const faceppPost = async (url, fields, imageField, image) => {
+  const form = new FormData();
+  Object.entries(fields).forEach(([name, value]) => form.append(name, value));
+  form.append(imageField, new Blob([image.buffer], { type: image.mimeType }), 'face.jpg');
+  return axios.post(url, form, { timeout: 15000 });
+};
+
+async function faceppDetectGetToken(image) {
   if (!FACEPP_API_KEY || !FACEPP_API_SECRET) {
     throw new Error('Face++ not configured');
   }
-  const form = new URLSearchParams();
-  form.append('api_key', FACEPP_API_KEY);
-  form.append('api_secret', FACEPP_API_SECRET);
-  form.append('image_base64', imageBase64);
-  form.append('return_landmark', '0');
-  form.append('return_attributes', 'none');
-
-  const resp = await axios.post(FACEPP_DETECT_URL, form.toString(), {
-    headers: { 'Content-Type': 'application/x-www-form-urlencoded' }, timeout: 15000
-  });
+  const resp = await faceppPost(FACEPP_DETECT_URL, {
+    api_key: FACEPP_API_KEY,
+    api_secret: FACEPP_API_SECRET,
+    return_landmark: '0',
+    return_attributes: 'none'
+  }, 'image_file', image);
   if (!resp.data || !Array.isArray(resp.data.faces) || resp.data.faces.length === 0) {
     throw new Error('No face detected');
   }
   return resp.data.faces[0].face_token;
 }
 
-async function faceppCompare(faceToken1, imageBase64) {
-  const form = new URLSearchParams();
-  form.append('api_key', FACEPP_API_KEY);
-  form.append('api_secret', FACEPP_API_SECRET);
-  form.append('face_token1', faceToken1);
-  form.append('image_base64_2', imageBase64);
-
-  const resp = await axios.post(FACEPP_COMPARE_URL, form.toString(), {
-    headers: { 'Content-Type': 'application/x-www-form-urlencoded' }, timeout: 15000
-  });
+async function faceppCompare(faceToken1, image) {
+  const resp = await faceppPost(FACEPP_COMPARE_URL, {
+    api_key: FACEPP_API_KEY,
+    api_secret: FACEPP_API_SECRET,
+    face_token1: faceToken1
+  }, 'image_file2', image);
   if (!resp.data || typeof resp.data.confidence !== 'number') {
     throw new Error('Invalid compare response');
   }
@@ -52,6 +100,304 @@ async function faceppCompare(faceToken1, imageBase64) {
   return resp.data.confidence / 100;
 }
 
+// Tracing. Each request gets a trace carried through async work by AsyncLocalStorage; spans are
+// opened around body parsing, JWT checks, every MongoDB command (driver command monitoring, so
+// Mongoose and direct collection calls alike), outgoing axios calls and background jobs. Finished
+// traces are tail-sampled — slow or failed ones are always kept, the rest at TRACE_SAMPLE_RATE —
+// and appended as Zipkin v2 JSON (one trace's span array per line) to a size-rotated local file.
+const TRACING_ENABLED = process.env.TRACING !== 'off';
+const TRACE_SERVICE_NAME = 'attendance-server';
+const TRACE_FILE = process.env.TRACE_FILE || path.join(__dirname, 'logs', 'traces.jsonl');
+const TRACE_FILE_MAX_BYTES = parseInt(process.env.TRACE_FILE_MAX_BYTES, 10) || 20 * 1024 * 1024;
+const TRACE_FILE_KEEP = 5;
+const TRACE_SLOW_MS = parseInt(process.env.TRACE_SLOW_MS, 10) || 1000;
+const TRACE_SAMPLE_RATE = process.env.TRACE_SAMPLE_RATE !== undefined ? Number(process.env.TRACE_SAMPLE_RATE) : 0.01;
+const MAX_SPANS_PER_TRACE = 256;
+const TRACE_FLUSH_INTERVAL_MS = 1000;
+
+const traceStorage = new AsyncLocalStorage();
+
+const startTrace = (name, { kind = 'SERVER', tags = {}, parent } = {}) => {
+  const trace = {
+    traceId: parent ? parent.trace.traceId : crypto.randomBytes(16).toString('hex'),
+    spans: [],
+    errored: false,
+    finished: false,
+    keep: false,
+    parentTrace: parent?.trace
+  };
+  trace.root = openSpan(trace, parent?.span, name, kind, tags);
+  return trace;
+};
+
+const openSpan = (trace, parentSpan, name, kind, tags) => {
+  const span = {
+    id: crypto.randomBytes(8).toString('hex'),
+    parentId: parentSpan?.id,
+    name,
+    kind,
+    tags,
+    timestamp: Date.now() * 1000,
+    startedAt: process.hrtime.bigint(),
+    duration: undefined
+  };
+  if (trace.spans.length < MAX_SPANS_PER_TRACE) trace.spans.push(span);
+  return span;
+};
+
+// A span under whatever is current; returns null outside a trace or once the trace was exported
+const startSpan = (name, tags = {}, kind) => {
+  const context = traceStorage.getStore();
+  if (!context || context.trace.finished) return null;
+  return openSpan(context.trace, context.span, name, kind, tags);
+};
+
+const endSpan = (span, error, tags) => {
+  if (!span || span.duration !== undefined) return;
+  span.duration = Number((process.hrtime.bigint() - span.startedAt) / 1000n);
+  if (tags) Object.assign(span.tags, tags);
+  if (error) {
+    span.tags.error = String(error.message || error).slice(0, 200);
+    const context = traceStorage.getStore();
+    if (context) context.trace.errored = true;
+  }
+};
+
+// Run fn with a child span as the current span, so work it starts nests under it
+const withSpan = (name, tags, fn) => {
+  const context = traceStorage.getStore();
+  const span = startSpan(name, tags);
+  if (!span) return fn();
+  return traceStorage.run({ trace: context.trace, span }, async () => {
+    try {
+      const result = await fn();
+      endSpan(span);
+      return result;
+    } catch (error) {
+      endSpan(span, error);
+      throw error;
+    }
+  });
+};
+
+const toZipkinSpan = (trace, span) => ({
+  traceId: trace.traceId,
+  id: span.id,
+  ...(span.parentId && { parentId: span.parentId }),
+  name: span.name,
+  ...(span.kind && { kind: span.kind }),
+  timestamp: span.timestamp,
+  duration: Math.max(1, span.duration),
+  localEndpoint: { serviceName: TRACE_SERVICE_NAME },
+  tags: Object.fromEntries(Object.entries(span.tags).map(([key, value]) => [key, String(value)]))
+});
+
+const pendingTraceLines = [];
+let traceFileSize = null;
+let traceWrite = Promise.resolve();
+
+const rotateTraceFile = async () => {
+  const { dir, name, ext } = path.parse(TRACE_FILE);
+  const rotated = (index) => path.join(dir, `${name}.${index}${ext}`);
+  await fs.promises.rm(rotated(TRACE_FILE_KEEP), { force: true });
+  for (let index = TRACE_FILE_KEEP - 1; index >= 1; index--) {
+    await fs.promises.rename(rotated(index), rotated(index + 1)).catch(() => {});
+  }
+  await fs.promises.rename(TRACE_FILE, rotated(1)).catch(() => {});
+  traceFileSize = 0;
+};
+
+const flushTraces = () => {
+  if (pendingTraceLines.length === 0) return traceWrite;
+  const chunk = pendingTraceLines.splice(0).join('');
+  traceWrite = traceWrite.then(async () => {
+    if (traceFileSize === null) {
+      await fs.promises.mkdir(path.dirname(TRACE_FILE), { recursive: true });
+      traceFileSize = await fs.promises.stat(TRACE_FILE).then(stat => stat.size, () => 0);
+    }
+    const chunkBytes = Buffer.byteLength(chunk);
+    if (traceFileSize > 0 && traceFileSize + chunkBytes > TRACE_FILE_MAX_BYTES) {
+      await rotateTraceFile();
+    }
+    await fs.promises.appendFile(TRACE_FILE, chunk);
+    traceFileSize += chunkBytes;
+  }).catch(error => console.error('Trace export error:', error.message));
+  return traceWrite;
+};
+
+const finishTrace = (trace) => {
+  if (trace.finished) return;
+  endSpan(trace.root);
+  trace.finished = true;
+  trace.spans.forEach(span => endSpan(span));
+
+  const durationMs = trace.root.duration / 1000;
+  const reason = trace.errored ? 'error'
+    : durationMs >= TRACE_SLOW_MS ? 'slow'
+      : trace.parentTrace?.keep ? 'parent'
+        : Math.random() < TRACE_SAMPLE_RATE ? 'sampled' : null;
+  incrementCounter('traces_total', 'Finished traces by tail-sampling decision', { kept: reason || 'dropped' });
+  if (!reason) return;
+
+  trace.keep = true;
+  pendingTraceLines.push(`${JSON.stringify(trace.spans.map(span => toZipkinSpan(trace, span)))}\n`);
+};
+
+if (TRACING_ENABLED) {
+  setInterval(flushTraces, TRACE_FLUSH_INTERVAL_MS).unref();
+}
+
+const traceRequest = (req, res, next) => {
+  if (!TRACING_ENABLED) return next();
+  const trace = startTrace(req.method, { tags: { 'http.method': req.method, 'http.path': req.path } });
+  res.set('X-Trace-Id', trace.traceId);
+  res.once('close', () => {
+    const route = req.route ? `${req.baseUrl}${req.route.path}` : req.path;
+    trace.root.name = `${req.method} ${route}`;
+    trace.root.tags['http.route'] = route;
+    trace.root.tags['http.status_code'] = res.statusCode;
+    if (res.statusCode >= 500 || !res.writableFinished) trace.errored = true;
+    finishTrace(trace);
+  });
+  traceStorage.run({ trace, span: trace.root }, next);
+};
+
+// Background work gets its own trace; started from a request it shares that trace ID, links to
+// the current span, and is kept whenever the request's trace was
+const traceJob = (name, fn) => (...args) => {
+  if (!TRACING_ENABLED) return fn(...args);
+  const parent = traceStorage.getStore();
+  const trace = startTrace(`job ${name}`, { kind: 'CONSUMER', parent });
+  return traceStorage.run({ trace, span: trace.root }, async () => {
+    try {
+      return await fn(...args);
+    } catch (error) {
+      trace.errored = true;
+      endSpan(trace.root, error);
+      throw error;
+    } finally {
+      finishTrace(trace);
+    }
+  });
+};
+
+// MongoDB commands, matched by the driver's request ID
+const pendingMongoSpans = new Map();
+const instrumentMongoClient = (client) => {
+  client.on('commandStarted', (event) => {
+    const collection = event.command[event.commandName];
+    const span = startSpan(`mongodb ${event.commandName}`, {
+      'db.system': 'mongodb',
+      'db.name': event.databaseName,
+      'db.operation': event.commandName,
+      ...(typeof collection === 'string' && { 'db.collection': collection })
+    }, 'CLIENT');
+    if (span) pendingMongoSpans.set(event.requestId, span);
+  });
+  client.on('commandSucceeded', (event) => {
+    endSpan(pendingMongoSpans.get(event.requestId));
+    pendingMongoSpans.delete(event.requestId);
+  });
+  client.on('commandFailed', (event) => {
+    endSpan(pendingMongoSpans.get(event.requestId), event.failure);
+    pendingMongoSpans.delete(event.requestId);
+  });
+};
+
+// Outgoing HTTP (Face++, the embedding API)
+axios.interceptors.request.use((config) => {
+  let host = '';
+  try {
+    host = new URL(config.url).host;
+  } catch (error) {
+    host = String(config.url);
+  }
+  config.traceSpan = startSpan(`${(config.method || 'get').toUpperCase()} ${host}`, {
+    'http.method': (config.method || 'get').toUpperCase(),
+    'http.host': host
+  }, 'CLIENT');
+  return config;
+});
+axios.interceptors.response.use((response) => {
+  endSpan(response.config.traceSpan, null, { 'http.status_code': response.status });
+  return response;
+}, (error) => {
+  endSpan(error.config?.traceSpan, error, error.response && { 'http.status_code': error.response.status });
+  throw error;
+});
+
+// Overload control. Event-loop delay, requests in flight and upstream work (Face++/embedding
+// calls, JSON parse jobs) are folded into one pressure figure, 1.0 being the configured limit.
+// Past it, low-priority routes (analytics, diagnostics, telemetry, bulk sync) get an immediate 503
+// with Retry-After; at 1.5x normal routes are shed too. Login and attendance are never shed.
+const OVERLOAD_LAG_MS = parseInt(process.env.OVERLOAD_LAG_MS, 10) || 200;
+const OVERLOAD_MAX_IN_FLIGHT = parseInt(process.env.OVERLOAD_MAX_IN_FLIGHT, 10) || 200;
+const OVERLOAD_MAX_UPSTREAM = parseInt(process.env.OVERLOAD_MAX_UPSTREAM, 10) || 50;
+const OVERLOAD_SAMPLE_INTERVAL_MS = 500;
+const SHED_PRESSURE = { low: 1, normal: 1.5 };
+const SHED_RETRY_AFTER_SECONDS = { low: 30, normal: 5 };
+
+const REQUEST_PRIORITIES = [
+  { priority: 'critical', path: /^\/api\/(auth\/|student\/attendance(-image)?$|health$)/ },
+  { priority: 'low', path: /^\/api\/(admin\/analytics|admin\/streaks\/backfill|face\/encode|telemetry\/|metrics$|student\/attendance\/sync$)/ }
+];
+// Long polls and media streams stay open by design and would read as a backlog
+const LONG_LIVED_PATH = /\/stream(\/|$)/;
+
+const eventLoopDelay = monitorEventLoopDelay({ resolution: 20 });
+eventLoopDelay.enable();
+let eventLoopLagMs = 0;
+let requestsInFlight = 0;
+let upstreamInFlight = 0;
+
+setInterval(() => {
+  eventLoopLagMs = eventLoopDelay.percentile(99) / 1e6;
+  eventLoopDelay.reset();
+}, OVERLOAD_SAMPLE_INTERVAL_MS).unref();
+
+axios.interceptors.request.use((config) => {
+  upstreamInFlight++;
+  return config;
+});
+axios.interceptors.response.use((response) => {
+  upstreamInFlight--;
+  return response;
+}, (error) => {
+  upstreamInFlight--;
+  throw error;
+});
+
+const overloadPressure = () => {
+  const pendingJsonJobs = jsonWorkers.reduce((total, entry) => total + entry.jobs.size, 0);
+  return Math.max(
+    eventLoopLagMs / OVERLOAD_LAG_MS,
+    requestsInFlight / OVERLOAD_MAX_IN_FLIGHT,
+    (upstreamInFlight + pendingJsonJobs) / OVERLOAD_MAX_UPSTREAM
+  );
+};
+
+const requestPriority = (req) =>
+  (REQUEST_PRIORITIES.find(entry => entry.path.test(req.path)) || { priority: 'normal' }).priority;
+
+const shedUnderOverload = (req, res, next) => {
+  const priority = requestPriority(req);
+  if (priority !== 'critical' && overloadPressure() >= SHED_PRESSURE[priority]) {
+    incrementCounter('requests_shed_total', 'Requests refused with 503 while overloaded', { priority });
+    res.set('Retry-After', String(SHED_RETRY_AFTER_SECONDS[priority]));
+    return res.status(503).json({
+      success: false,
+      error: 'Server is busy, please try again shortly'
+    });
+  }
+
+  if (LONG_LIVED_PATH.test(req.path)) return next();
+  requestsInFlight++;
+  res.once('close', () => {
+    requestsInFlight--;
+  });
+  next();
+};
+
 const app = express();
 const PORT = process.env.PORT || 3000;
 const JWT_SECRET = process.env.JWT_SECRET || 'attendance-app-professional-2024';
@@ -66,11 +412,49 @@ if (!fs.existsSync(uploadsDir)) {
 app.use(cors({
   origin: '*',
   methods: ['GET', 'POST', 'PUT', 'DELETE'],
-  allowedHeaders: ['Content-Type', 'Authorization']
+  allowedHeaders: ['Content-Type', 'Authorization', 'If-None-Match', 'X-Chunk-Checksum', 'X-Chunk-Encoding'],
+  exposedHeaders: ['ETag', 'Server-Timing', 'X-Trace-Id']
 }));
-app.use(express.json({ limit: '100mb' }));
-app.use(express.urlencoded({ extended: true, limit: '100mb' }));
-app.use('/uploads', express.static(uploadsDir));
+app.use(traceRequest);
+app.use((req, res, next) => shedUnderOverload(req, res, next));
+// JSON and form bodies are parsed within a per-route budget (see BODY_BUDGETS)
+app.use((req, res, next) => {
+  const span = startSpan('body.parse');
+  parseBodyWithinBudget(req, res, (error) => {
+    endSpan(span, error);
+    next(error);
+  });
+});
+
+// Report time spent after the body arrived, so the app can separate network time from server work
+app.use((req, res, next) => {
+  const startedAt = process.hrtime.bigint();
+  const writeHead = res.writeHead;
+  res.writeHead = function (...args) {
+    if (!res.headersSent) {
+      const durationMs = Number(process.hrtime.bigint() - startedAt) / 1e6;
+      res.setHeader('Server-Timing', `app;dur=${durationMs.toFixed(1)}`);
+    }
+    return writeHead.apply(this, args);
+  };
+  next();
+});
+// Subdirectories of uploads that are only served through authenticated routes: HLS renditions,
+// image variants (profile faces among them), the content-addressed chunk store and in-progress
+// uploads. The path is normalised first, so 'materials/../hls/...' cannot reach them either.
+const PRIVATE_UPLOAD_DIRS = ['hls', 'variants', 'chunks', 'incoming'];
+app.use('/uploads', (req, res, next) => {
+  let topLevel;
+  try {
+    topLevel = path.posix.normalize(decodeURIComponent(req.path)).split('/').filter(Boolean)[0] || '';
+  } catch (error) {
+    return res.status(400).json({ success: false, error: 'Invalid path' });
+  }
+  if (PRIVATE_UPLOAD_DIRS.includes(topLevel.toLowerCase())) {
+    return res.status(404).json({ success: false, error: 'Not found' });
+  }
+  next();
+}, express.static(uploadsDir));
 
 // Professional logging middleware
 app.use((req, res, next) => {
@@ -85,9 +469,12 @@ app.use((req, res, next) => {
 // MongoDB Connection
 const MONGODB_URI = process.env.MONGODB_URI || 'mongodb://127.0.0.1:27017/attendance_professional';
 
-mongoose.connect(MONGODB_URI, {
+const connectToDatabase = () => mongoose.connect(MONGODB_URI, {
   useNewUrlParser: true,
   useUnifiedTopology: true,
+  monitorCommands: TRACING_ENABLED,
+}).then(() => {
+  if (TRACING_ENABLED) instrumentMongoClient(mongoose.connection.getClient());
 }).catch(error => {
   console.error('MongoDB connection error:', error);
 });
@@ -112,6 +499,425 @@ function computeCosineSimilarity(a, b) {
   return dot / (Math.sqrt(normA) * Math.sqrt(normB));
 }
 
+// Mergeable t-digest sketch (merging variant, k1 scale function) used for lateness percentiles.
+// Centroids are plain { mean, count } objects so they can be stored in and merged from MongoDB.
+class TDigest {
+  constructor(compression = 100) {
+    this.compression = compression;
+    this.centroids = [];
+    this.buffer = [];
+    this.count = 0;
+    this.min = Infinity;
+    this.max = -Infinity;
+  }
+
+  add(mean, count = 1) {
+    if (!Number.isFinite(mean) || count <= 0) return;
+    this.buffer.push({ mean, count });
+    this.count += count;
+    if (mean < this.min) this.min = mean;
+    if (mean > this.max) this.max = mean;
+    if (this.buffer.length > this.compression * 4) this.compress();
+  }
+
+  merge(centroids, min, max) {
+    centroids.forEach(c => this.add(c.mean, c.count));
+    if (Number.isFinite(min) && min < this.min) this.min = min;
+    if (Number.isFinite(max) && max > this.max) this.max = max;
+  }
+
+  compress() {
+    if (this.buffer.length === 0) return;
+    const all = this.centroids.concat(this.buffer).sort((a, b) => a.mean - b.mean);
+    this.buffer = [];
+    const total = this.count;
+    const k = (q) => (this.compression / (2 * Math.PI)) * Math.asin(2 * q - 1);
+    const merged = [];
+    let current = { ...all[0] };
+    let weightSoFar = 0;
+    let kLeft = k(0);
+    for (let i = 1; i < all.length; i++) {
+      const next = all[i];
+      const q = (weightSoFar + current.count + next.count) / total;
+      if (k(q) - kLeft <= 1) {
+        current.mean += (next.mean - current.mean) * next.count / (current.count + next.count);
+        current.count += next.count;
+      } else {
+        merged.push(current);
+        weightSoFar += current.count;
+        kLeft = k(weightSoFar / total);
+        current = { ...next };
+      }
+    }
+    merged.push(current);
+    this.centroids = merged;
+  }
+
+  quantile(q) {
+    this.compress();
+    const c = this.centroids;
+    if (c.length === 0) return null;
+    if (c.length === 1 || this.min === this.max) return c[0].mean;
+    const index = Math.max(0, Math.min(1, q)) * this.count;
+    if (index < c[0].count / 2) {
+      return this.min + (c[0].mean - this.min) * (index / (c[0].count / 2));
+    }
+    let weightSoFar = c[0].count / 2;
+    for (let i = 0; i < c.length - 1; i++) {
+      const step = (c[i].count + c[i + 1].count) / 2;
+      if (weightSoFar + step > index) {
+        const t = (index - weightSoFar) / step;
+        return c[i].mean + t * (c[i + 1].mean - c[i].mean);
+      }
+      weightSoFar += step;
+    }
+    const last = c[c.length - 1];
+    const t = Math.min(1, (index - weightSoFar) / (last.count / 2));
+    return last.mean + t * (this.max - last.mean);
+  }
+}
+
+// Series decimation for chart endpoints. Both return indices into the input so callers keep their
+// original rows. LTTB (largest-triangle-three-buckets) keeps the visual shape of a line; min/max keeps
+// every bucket's extremes, which matters when spikes must never be dropped.
+const lttbIndices = (xs, ys, threshold) => {
+  const length = xs.length;
+  if (threshold >= length || threshold < 3) return xs.map((x, i) => i);
+
+  const selected = [0];
+  const bucketSize = (length - 2) / (threshold - 2);
+  let a = 0;
+  for (let bucket = 0; bucket < threshold - 2; bucket++) {
+    const nextStart = Math.floor((bucket + 1) * bucketSize) + 1;
+    const nextEnd = Math.min(Math.floor((bucket + 2) * bucketSize) + 1, length);
+    let avgX = 0;
+    let avgY = 0;
+    for (let j = nextStart; j < nextEnd; j++) {
+      avgX += xs[j];
+      avgY += ys[j];
+    }
+    avgX /= nextEnd - nextStart;
+    avgY /= nextEnd - nextStart;
+
+    const start = Math.floor(bucket * bucketSize) + 1;
+    const end = Math.floor((bucket + 1) * bucketSize) + 1;
+    let maxArea = -1;
+    let next = start;
+    for (let j = start; j < end; j++) {
+      const area = Math.abs((xs[a] - avgX) * (ys[j] - ys[a]) - (xs[a] - xs[j]) * (avgY - ys[a]));
+      if (area > maxArea) {
+        maxArea = area;
+        next = j;
+      }
+    }
+    selected.push(next);
+    a = next;
+  }
+  selected.push(length - 1);
+  return selected;
+};
+
+const minMaxIndices = (ys, threshold) => {
+  const length = ys.length;
+  if (threshold >= length || threshold < 2) return ys.map((y, i) => i);
+
+  const selected = [];
+  const buckets = Math.floor(threshold / 2);
+  for (let bucket = 0; bucket < buckets; bucket++) {
+    const start = Math.floor(bucket * length / buckets);
+    const end = Math.floor((bucket + 1) * length / buckets);
+    let min = start;
+    let max = start;
+    for (let j = start + 1; j < end; j++) {
+      if (ys[j] < ys[min]) min = j;
+      if (ys[j] > ys[max]) max = j;
+    }
+    selected.push(Math.min(min, max));
+    if (min !== max) selected.push(Math.max(min, max));
+  }
+  return selected;
+};
+
+// Daily turnout against the enrolled roster: attendance rows only exist for students who showed up,
+// so each course session's expected count comes from its close-out (marked + absentees) or, for
+// sessions not closed yet, from the current roster
+const buildDailyTurnout = async (since, courseFilter) => {
+  const sessions = await Attendance.aggregate([
+    { $match: { timestamp: { $gte: since }, ...courseFilter } },
+    {
+      $group: {
+        _id: { date: '$date', courseCode: '$courseCode' },
+        totalSessions: { $sum: 1 },
+        presentSessions: { $sum: { $cond: [{ $eq: ['$status', 'present'] }, 1, 0] } },
+        lateSessions: { $sum: { $cond: [{ $eq: ['$status', 'late'] }, 1, 0] } },
+        markedSessions: { $sum: { $cond: [{ $in: ['$status', ['present', 'late', 'excused']] }, 1, 0] } }
+      }
+    }
+  ]);
+  if (sessions.length === 0) return [];
+
+  const courseCodes = [...new Set(sessions.map(session => session._id.courseCode))];
+  const dates = [...new Set(sessions.map(session => session._id.date))];
+  const [courses, closeOuts] = await Promise.all([
+    Course.find({ courseCode: { $in: courseCodes } }).select('courseCode enrolledStudents').lean(),
+    SessionCloseOut.find({ courseCode: { $in: courseCodes }, date: { $in: dates } }).select('courseCode date absentees').lean()
+  ]);
+  const rosterSizes = new Map(courses.map(course => [course.courseCode, (course.enrolledStudents || []).length]));
+  const absentees = new Map(closeOuts.map(closeOut => [`${closeOut.courseCode}|${closeOut.date}`, closeOut.absentees]));
+
+  const days = new Map();
+  sessions.forEach(({ _id, totalSessions, presentSessions, lateSessions, markedSessions }) => {
+    const closed = absentees.get(`${_id.courseCode}|${_id.date}`);
+    const enrolled = closed !== undefined
+      ? markedSessions + closed
+      : Math.max(rosterSizes.get(_id.courseCode) || 0, markedSessions);
+    if (!days.has(_id.date)) {
+      days.set(_id.date, { _id: _id.date, totalSessions: 0, presentSessions: 0, lateSessions: 0, enrolled: 0 });
+    }
+    const day = days.get(_id.date);
+    day.totalSessions += totalSessions;
+    day.presentSessions += presentSessions;
+    day.lateSessions += lateSessions;
+    day.enrolled += enrolled;
+  });
+
+  return [...days.values()]
+    .sort((a, b) => (a._id < b._id ? -1 : 1))
+    .map(day => ({
+      ...day,
+      attendanceRate: day.enrolled > 0 ? ((day.presentSessions + day.lateSessions) / day.enrolled) * 100 : 0
+    }));
+};
+
+// Downsample a daily series to at most `points` rows (query: points, decimation=lttb|minmax)
+const decimateSeries = (series, query, xOf, yOf) => {
+  const points = Math.min(parseInt(query.points, 10) || 0, 2000);
+  if (points <= 0 || points >= series.length) return series;
+  const indices = query.decimation === 'minmax'
+    ? minMaxIndices(series.map(yOf), points)
+    : lttbIndices(series.map(xOf), series.map(yOf), points);
+  return indices.map(i => series[i]);
+};
+
+// Material text extraction for the search index (plain text, PDF content streams, DOCX, legacy DOC)
+const MAX_EXTRACTED_TEXT = 200000;
+
+const extractPdfText = async (buffer) => {
+  const parts = [];
+  const raw = buffer.toString('latin1');
+  const streamPattern = /<<([^]*?)>>\s*stream\r?\n/g;
+  let match;
+  while ((match = streamPattern.exec(raw)) && parts.join(' ').length < MAX_EXTRACTED_TEXT) {
+    const start = match.index + match[0].length;
+    const end = raw.indexOf('endstream', start);
+    if (end < 0) break;
+    let content = buffer.subarray(start, end);
+    if (/FlateDecode/.test(match[1])) {
+      try {
+        content = await inflateAsync(content);
+      } catch (error) {
+        continue;
+      }
+    } else if (/\/Filter/.test(match[1])) {
+      continue;
+    }
+    // Literal strings shown with Tj / TJ / ' / " operators
+    const text = content.toString('latin1');
+    const literal = /\(((?:\\.|[^\\)])*)\)/g;
+    let piece;
+    while ((piece = literal.exec(text))) {
+      parts.push(piece[1].replace(/\\([nrtbf()\\])/g, (m, c) => ({ n: ' ', r: ' ', t: ' ', b: '', f: '' }[c] ?? c)));
+    }
+    streamPattern.lastIndex = end;
+  }
+  return parts.join(' ');
+};
+
+const extractDocxText = async (buffer) => {
+  // Locate word/document.xml through the zip central directory
+  const eocd = buffer.lastIndexOf(Buffer.from([0x50, 0x4b, 0x05, 0x06]));
+  if (eocd < 0) return '';
+  const entries = buffer.readUInt16LE(eocd + 10);
+  let offset = buffer.readUInt32LE(eocd + 16);
+  for (let i = 0; i < entries && offset + 46 <= buffer.length; i++) {
+    const method = buffer.readUInt16LE(offset + 10);
+    const compressedSize = buffer.readUInt32LE(offset + 20);
+    const nameLength = buffer.readUInt16LE(offset + 28);
+    const extraLength = buffer.readUInt16LE(offset + 30);
+    const commentLength = buffer.readUInt16LE(offset + 32);
+    const localOffset = buffer.readUInt32LE(offset + 42);
+    const name = buffer.toString('utf8', offset + 46, offset + 46 + nameLength);
+    if (name === 'word/document.xml') {
+      const localNameLength = buffer.readUInt16LE(localOffset + 26);
+      const localExtraLength = buffer.readUInt16LE(localOffset + 28);
+      const dataStart = localOffset + 30 + localNameLength + localExtraLength;
+      const data = buffer.subarray(dataStart, dataStart + compressedSize);
+      const xml = (method === 8 ? await inflateRawAsync(data) : data).toString('utf8');
+      return xml.replace(/<\/w:p>/g, ' ').replace(/<[^>]+>/g, '').replace(/&[a-z]+;/g, ' ');
+    }
+    offset += 46 + nameLength + extraLength + commentLength;
+  }
+  return '';
+};
+
+// Only these types are read at all. Plain text and legacy .doc are scanned from the head of the
+// file; PDF and DOCX need the whole file and are skipped above MAX_TEXT_SOURCE_BYTES.
+const TEXT_EXTENSIONS = ['.txt', '.pdf', '.docx', '.doc'];
+const MAX_TEXT_PREFIX_BYTES = 2 * 1024 * 1024;
+const MAX_TEXT_SOURCE_BYTES = 25 * 1024 * 1024;
+
+const extractMaterialText = async (material) => {
+  try {
+    const extension = path.extname(material.fileName || material.filePath || '').toLowerCase();
+    if (!TEXT_EXTENSIONS.includes(extension)) return '';
+    const headOnly = extension === '.txt' || extension === '.doc';
+    if (!headOnly && material.fileSize > MAX_TEXT_SOURCE_BYTES) return '';
+
+    const buffer = await readMaterialFile(material, headOnly ? MAX_TEXT_PREFIX_BYTES : MAX_TEXT_SOURCE_BYTES);
+    if (!buffer) return '';
+    let text = '';
+    if (extension === '.txt') {
+      text = buffer.toString('utf8');
+    } else if (extension === '.pdf') {
+      text = await extractPdfText(buffer);
+    } else if (extension === '.docx') {
+      text = await extractDocxText(buffer);
+    } else if (extension === '.doc') {
+      text = (buffer.toString('latin1').match(/[\x20-\x7e]{4,}/g) || []).join(' ');
+    }
+    return text.slice(0, MAX_EXTRACTED_TEXT);
+  } catch (error) {
+    console.error('Material text extraction error:', error.message);
+    return '';
+  }
+};
+
+// In-memory inverted index over materials, ranked with BM25. Title and tags are weighted by
+// repeating their terms; removals drop the document's postings right away, and the background
+// compaction rebuilds the sorted term list used for prefix matching.
+class MaterialSearchIndex {
+  constructor() {
+    this.docs = new Map();
+    this.postings = new Map();
+    this.sortedTerms = [];
+    this.newTerms = new Set();
+    this.totalLength = 0;
+  }
+
+  static tokenize(text) {
+    return String(text || '').toLowerCase().match(/[\p{L}\p{N}]+/gu) || [];
+  }
+
+  add(material, bodyText = '') {
+    const id = String(material._id);
+    this.remove(id);
+
+    const tokens = [
+      ...Array(3).fill(MaterialSearchIndex.tokenize(material.title)).flat(),
+      ...Array(2).fill(MaterialSearchIndex.tokenize((material.tags || []).join(' '))).flat(),
+      ...MaterialSearchIndex.tokenize(material.description),
+      ...MaterialSearchIndex.tokenize(material.fileName),
+      ...MaterialSearchIndex.tokenize(bodyText)
+    ];
+    const frequencies = new Map();
+    tokens.forEach(token => frequencies.set(token, (frequencies.get(token) || 0) + 1));
+
+    this.docs.set(id, {
+      courseCode: material.courseCode,
+      publishDate: material.publishDate ? new Date(material.publishDate) : null,
+      length: tokens.length,
+      terms: [...frequencies.keys()]
+    });
+    this.totalLength += tokens.length;
+    frequencies.forEach((tf, term) => {
+      if (!this.postings.has(term)) {
+        this.postings.set(term, new Map());
+        this.newTerms.add(term);
+      }
+      this.postings.get(term).set(id, tf);
+    });
+  }
+
+  // Drop the document's postings through its stored term list, so re-adding it leaves no stale terms
+  remove(id) {
+    const key = String(id);
+    const doc = this.docs.get(key);
+    if (!doc) return;
+    this.docs.delete(key);
+    this.totalLength -= doc.length;
+    doc.terms.forEach(term => {
+      const posting = this.postings.get(term);
+      if (!posting) return;
+      posting.delete(key);
+      if (posting.size === 0) this.postings.delete(term);
+    });
+  }
+
+  // Re-sort the term list used for prefix expansion once terms were added or dropped
+  compact() {
+    if (this.newTerms.size > 0 || this.sortedTerms.length !== this.postings.size) {
+      this.sortedTerms = [...this.postings.keys()].sort();
+      this.newTerms.clear();
+    }
+  }
+
+  expandPrefix(prefix, limit = 50) {
+    const terms = [];
+    let lo = 0;
+    let hi = this.sortedTerms.length;
+    while (lo < hi) {
+      const mid = (lo + hi) >>> 1;
+      if (this.sortedTerms[mid] < prefix) lo = mid + 1;
+      else hi = mid;
+    }
+    for (let i = lo; i < this.sortedTerms.length && terms.length < limit && this.sortedTerms[i].startsWith(prefix); i++) {
+      terms.push(this.sortedTerms[i]);
+    }
+    for (const term of this.newTerms) {
+      if (terms.length >= limit) break;
+      if (term.startsWith(prefix) && !terms.includes(term)) terms.push(term);
+    }
+    return terms;
+  }
+
+  search(query, { courseCodes = null, publishedBefore = null, limit = 20 } = {}) {
+    const queryTokens = MaterialSearchIndex.tokenize(query);
+    if (queryTokens.length === 0 || this.docs.size === 0) return [];
+
+    const k1 = 1.2;
+    const b = 0.75;
+    const docCount = this.docs.size;
+    const avgLength = this.totalLength / docCount || 1;
+    const scores = new Map();
+
+    queryTokens.forEach((token, index) => {
+      // Every query term also matches as a prefix; the last one is usually still being typed
+      const isLast = index === queryTokens.length - 1;
+      const terms = this.postings.has(token) && !isLast ? [token] : this.expandPrefix(token, isLast ? 50 : 10);
+      terms.forEach(term => {
+        const posting = this.postings.get(term);
+        if (!posting) return;
+        const df = posting.size;
+        const idf = Math.log(1 + (docCount - df + 0.5) / (df + 0.5));
+        const exactBoost = term === token ? 1 : 0.7;
+        posting.forEach((tf, id) => {
+          const doc = this.docs.get(id);
+          if (!doc) return;
+          if (courseCodes && !courseCodes.includes(doc.courseCode)) return;
+          if (publishedBefore && doc.publishDate && doc.publishDate > publishedBefore) return;
+          const score = idf * exactBoost * (tf * (k1 + 1)) / (tf + k1 * (1 - b + b * doc.length / avgLength));
+          scores.set(id, (scores.get(id) || 0) + score);
+        });
+      });
+    });
+
+    return [...scores.entries()]
+      .sort((a, c) => c[1] - a[1])
+      .slice(0, limit)
+      .map(([id, score]) => ({ id, score }));
+  }
+}
+
 // External Face API config
 const FACE_API_URL = process.env.FACE_API_URL || '';
 const FACE_API_KEY = process.env.FACE_API_KEY || '';
@@ -180,6 +986,7 @@ const userSchema = new mongoose.Schema({
   faceEncodings: [Number],
   faceToken: String,
   profileImage: String,
+  profileImageHash: String,
   phoneNumber: String,
   email: String,
   address: String,
@@ -206,6 +1013,16 @@ const userSchema = new mongoose.Schema({
   }
 });
 
+// Version profile image URLs by content so image variants can be cached as immutable
+userSchema.pre('save', function(next) {
+  if (this.isModified('profileImage')) {
+    this.profileImageHash = this.profileImage
+      ? crypto.createHash('sha1').update(this.profileImage).digest('hex').slice(0, 16)
+      : undefined;
+  }
+  next();
+});
+
 // Enhanced Course Schema
 const courseSchema = new mongoose.Schema({
   courseCode: { 
@@ -268,6 +1085,35 @@ const materialSchema = new mongoose.Schema({
   filePath: String,
   fileSize: Number,
   fileName: String,
+  fileHash: String,
+  // Ordered content-defined chunks of the current file version (see the chunk store below)
+  manifest: {
+    type: [{ _id: false, hash: String, size: Number }],
+    select: false
+  },
+  revision: { type: Number, default: 1 },
+  revisions: {
+    type: [{
+      _id: false,
+      revision: Number,
+      fileName: String,
+      fileSize: Number,
+      fileHash: String,
+      filePath: String,
+      manifest: [{ _id: false, hash: String, size: Number }],
+      uploadedBy: String,
+      uploadedAt: Date
+    }],
+    select: false
+  },
+  // HLS renditions of a video material's current revision
+  streaming: {
+    status: { type: String, enum: ['pending', 'processing', 'ready', 'failed'] },
+    revision: Number,
+    durationSeconds: Number,
+    renditions: [{ _id: false, name: String, height: Number, bandwidth: Number }],
+    error: String
+  },
   url: String,
   isPublic: { type: Boolean, default: true },
   publishDate: { type: Date, default: Date.now },
@@ -277,7 +1123,8 @@ const materialSchema = new mongoose.Schema({
     required: true 
   },
   tags: [String],
-  downloadCount: { type: Number, default: 0 },
+  // Not part of material payloads: it changes on every download, and list ETags must not
+  downloadCount: { type: Number, default: 0, select: false },
   isActive: { 
     type: Boolean, 
     default: true 
@@ -335,6 +1182,7 @@ const attendanceSchema = new mongoose.Schema({
   },
   notes: String,
   verifiedBy: String,
+  captureTier: String,
   isLate: { type: Boolean, default: false },
   lateMinutes: { type: Number, default: 0 },
   createdAt: { 
@@ -359,10 +1207,60 @@ const notificationSchema = new mongoose.Schema({
   createdAt: { type: Date, default: Date.now }
 });
 
+// Attendance Heatmap Schema (course × weekday × hour counters, one document per cell)
+const attendanceHeatmapSchema = new mongoose.Schema({
+  courseCode: { type: String, required: true },
+  weekday: { type: Number, min: 0, max: 6, required: true },
+  hour: { type: Number, min: 0, max: 23, required: true },
+  present: { type: Number, default: 0 },
+  late: { type: Number, default: 0 },
+  absent: { type: Number, default: 0 },
+  excused: { type: Number, default: 0 }
+});
+
+// Lateness Digest Schema (one t-digest per course per day, fed from lateMinutes)
+const latenessDigestSchema = new mongoose.Schema({
+  courseCode: { type: String, required: true },
+  date: { type: String, required: true },
+  centroids: [{ _id: false, mean: Number, count: Number }],
+  count: { type: Number, default: 0 },
+  sum: { type: Number, default: 0 },
+  min: Number,
+  max: Number,
+  unmerged: { type: Number, default: 0 }
+});
+
+// Student Summary Schema (per student and course; holds incrementally maintained streak state)
+const studentSummarySchema = new mongoose.Schema({
+  studentId: { type: String, required: true },
+  courseCode: { type: String, required: true },
+  currentStreak: { type: Number, default: 0 },
+  bestStreak: { type: Number, default: 0 },
+  lastSessionDate: String,
+  lastAttendedDate: String,
+  updatedAt: { type: Date, default: Date.now }
+});
+
+// Session Close-Out Schema (one document per course session whose absentees have been processed)
+const sessionCloseOutSchema = new mongoose.Schema({
+  courseCode: { type: String, required: true },
+  date: { type: String, required: true },
+  absentees: { type: Number, default: 0 },
+  weekday: Number,
+  hour: Number,
+  closedAt: { type: Date, default: Date.now }
+});
+
 // Create indexes for better performance
 attendanceSchema.index({ studentId: 1, courseCode: 1, date: 1 }, { unique: true });
+attendanceSchema.index({ courseCode: 1, date: 1 });
+attendanceSchema.index({ studentId: 1, _id: 1 });
 materialSchema.index({ courseCode: 1, isActive: 1 });
 notificationSchema.index({ userId: 1, isRead: 1 });
+attendanceHeatmapSchema.index({ courseCode: 1, weekday: 1, hour: 1 }, { unique: true });
+latenessDigestSchema.index({ courseCode: 1, date: 1 }, { unique: true });
+studentSummarySchema.index({ studentId: 1, courseCode: 1 }, { unique: true });
+sessionCloseOutSchema.index({ courseCode: 1, date: 1 }, { unique: true });
 
 // Models
 const User = mongoose.model('User', userSchema);
@@ -370,6 +1268,63 @@ const Course = mongoose.model('Course', courseSchema);
 const Attendance = mongoose.model('Attendance', attendanceSchema);
 const Material = mongoose.model('Material', materialSchema);
 const Notification = mongoose.model('Notification', notificationSchema);
+const AttendanceHeatmap = mongoose.model('AttendanceHeatmap', attendanceHeatmapSchema);
+const LatenessDigest = mongoose.model('LatenessDigest', latenessDigestSchema);
+const StudentSummary = mongoose.model('StudentSummary', studentSummarySchema);
+const SessionCloseOut = mongoose.model('SessionCloseOut', sessionCloseOutSchema);
+
+// Hot-path data access. Attendance submissions read the student, the course and the day's record
+// and insert one attendance row; these go straight to the driver with lean projections instead
+// of hydrating Mongoose documents. insertAttendance stores exactly what Attendance#save() would:
+// schema key order, defaults filled, undefined fields and empty location omitted, __v: 0.
+const STUDENT_ATTENDANCE_PROJECTION = { studentId: 1, studentName: 1, enrolledCourses: 1, faceEncodings: 1, faceToken: 1 };
+
+const findActiveStudent = (studentId, projection = STUDENT_ATTENDANCE_PROJECTION) =>
+  User.collection.findOne({ studentId, role: 'student', isActive: true }, { projection });
+
+const activeCourseExists = async (courseCode) =>
+  Boolean(await Course.collection.findOne({ courseCode, isActive: true }, { projection: { _id: 1 } }));
+
+const attendanceExists = async (studentId, courseCode, date) =>
+  Boolean(await Attendance.collection.findOne({ studentId, courseCode, date }, { projection: { _id: 1 } }));
+
+const shapeAttendanceDocument = (fields) => {
+  const now = new Date();
+  const location = fields.location && {
+    ...(fields.location.latitude !== undefined && { latitude: Number(fields.location.latitude) }),
+    ...(fields.location.longitude !== undefined && { longitude: Number(fields.location.longitude) })
+  };
+  const document = {
+    _id: fields._id || new mongoose.Types.ObjectId(),
+    studentId: fields.studentId,
+    studentName: fields.studentName,
+    courseCode: fields.courseCode,
+    timestamp: fields.timestamp || now,
+    date: fields.date,
+    status: fields.status || 'present',
+    confidenceScore: fields.confidenceScore ?? 0.95,
+    location: location && Object.keys(location).length > 0 ? location : undefined,
+    deviceInfo: fields.deviceInfo,
+    ipAddress: fields.ipAddress,
+    method: fields.method || 'face_recognition',
+    notes: fields.notes,
+    verifiedBy: fields.verifiedBy,
+    captureTier: fields.captureTier,
+    isLate: fields.isLate ?? false,
+    lateMinutes: fields.lateMinutes ?? 0,
+    createdAt: fields.createdAt || now,
+    __v: 0
+  };
+  Object.keys(document).forEach(key => document[key] === undefined && delete document[key]);
+  return document;
+};
+
+// Callers validate fields beforehand (see BODY_SCHEMAS); duplicate keys still raise E11000
+const insertAttendance = async (fields) => {
+  const document = shapeAttendanceDocument(fields);
+  await Attendance.collection.insertOne(document);
+  return document;
+};
 
 // Enhanced file upload configuration
 const storage = multer.diskStorage({
@@ -386,24 +1341,30 @@ const storage = multer.diskStorage({
   }
 });
 
+const MAX_MATERIAL_FILE_SIZE = 50 * 1024 * 1024; // 50MB limit
+const MAX_VIDEO_FILE_SIZE = 500 * 1024 * 1024; // videos only through chunked uploads
+const ALLOWED_MATERIAL_TYPES = [
+  'image/jpeg', 'image/png', 'image/gif',
+  'application/pdf',
+  'application/msword',
+  'application/vnd.openxmlformats-officedocument.wordprocessingml.document',
+  'text/plain',
+  'video/mp4', 'video/quicktime', 'video/webm'
+];
+const isVideoType = (mimeType) => String(mimeType || '').startsWith('video/');
+const materialTypeForMime = (mimeType) =>
+  isVideoType(mimeType) ? 'video' : String(mimeType || '').startsWith('image/') ? 'image' : null;
+
 const upload = multer({
   storage: storage,
   limits: { 
-    fileSize: 50 * 1024 * 1024 // 50MB limit
+    fileSize: MAX_MATERIAL_FILE_SIZE
   },
   fileFilter: (req, file, cb) => {
-    const allowedTypes = [
-      'image/jpeg', 'image/png', 'image/gif',
-      'application/pdf',
-      'application/msword',
-      'application/vnd.openxmlformats-officedocument.wordprocessingml.document',
-      'text/plain'
-    ];
-    
-    if (allowedTypes.includes(file.mimetype)) {
+    if (ALLOWED_MATERIAL_TYPES.includes(file.mimetype)) {
       cb(null, true);
     } else {
-      cb(new Error('Invalid file type. Only images, PDFs, and documents are allowed.'));
+      cb(new Error('Invalid file type. Only images, PDFs, documents and videos are allowed.'));
     }
   }
 });
@@ -420,7 +1381,9 @@ const authenticateToken = (req, res, next) => {
     });
   }
 
+  const span = startSpan('jwt.verify');
   jwt.verify(token, JWT_SECRET, (err, user) => {
+    endSpan(span, err);
     if (err) {
       return res.status(403).json({ 
         success: false,
@@ -453,6 +1416,51 @@ const requireStudent = (req, res, next) => {
   next();
 };
 
+// Collection versions for conditional GETs. Every scope ("courses", "materials:ICT651",
+// "notifications:S1001", ...) carries a counter that write handlers bump; a response's weak ETag is
+// derived from the versions of the scopes it reads, so If-None-Match is answered before any query.
+const BOOT_EPOCH = Date.now().toString(36);
+const scopeVersions = new Map();
+
+const bumpVersion = (...scopes) => {
+  scopes.forEach(scope => scopeVersions.set(scope, (scopeVersions.get(scope) || 0) + 1));
+};
+
+const bumpMaterialVersions = (courseCode) => bumpVersion('materials', `materials:${courseCode}`);
+
+// Materials published in the future become visible without a write, so bump when they go live
+const MAX_TIMER_DELAY_MS = 2147483647;
+const scheduleMaterialPublishBump = (courseCode, publishDate) => {
+  const delay = new Date(publishDate).getTime() - Date.now();
+  if (!(delay > 0)) return;
+  const timer = setTimeout(() => {
+    if (delay > MAX_TIMER_DELAY_MS) scheduleMaterialPublishBump(courseCode, publishDate);
+    else bumpMaterialVersions(courseCode);
+  }, Math.min(delay, MAX_TIMER_DELAY_MS));
+  timer.unref();
+};
+
+const versionTag = (scopes) => {
+  const scopeHash = crypto.createHash('sha1').update(scopes.join('|')).digest('base64url').slice(0, 10);
+  const versions = scopes.map(scope => scopeVersions.get(scope) || 0).join('.');
+  return `W/"${BOOT_EPOCH}-${scopeHash}-${versions}"`;
+};
+
+// Conditional GET middleware; scopesFor(req) lists the scopes the handler reads
+const conditionalGet = (scopesFor) => (req, res, next) => {
+  const etag = versionTag(scopesFor(req));
+  res.setHeader('Cache-Control', 'private, no-cache');
+  if (req.headers['if-none-match'] === etag) {
+    return res.status(304).end();
+  }
+  res.setHeader('ETag', etag);
+  next();
+};
+
+const userScope = (req) => `user:${req.user.role === 'admin' ? req.user.uniqueId : req.user.studentId}`;
+const notificationScope = (req) => `notifications:${req.user.role === 'admin' ? req.user.uniqueId : req.user.studentId}`;
+const dayScope = () => `day:${new Date().toISOString().split('T')[0]}`;
+
 // Utility function to create notifications
 const createNotification = async (userId, title, message, type = 'info', courseCode = null) => {
   try {
@@ -464,47 +1472,798 @@ const createNotification = async (userId, title, message, type = 'info', courseC
       courseCode
     });
     await notification.save();
+    bumpVersion(`notifications:${userId}`);
   } catch (error) {
     console.error('Error creating notification:', error);
   }
 };
 
-// Enhanced health check endpoint
-app.get('/api/health', (req, res) => {
-  const healthCheck = {
-    success: true,
-    status: 'Server running',
-    timestamp: new Date().toISOString(),
-    environment: process.env.NODE_ENV || 'development',
-    mongodb: mongoose.connection.readyState === 1 ? 'connected' : 'disconnected',
-    uptime: process.uptime(),
-    memory: process.memoryUsage(),
-    version: '2.0.0'
-  };
-  res.json(healthCheck);
-});
+// Heatmap cell for an attendance record (server local time, same as the late cut-off)
+const heatmapCellFor = (record) => {
+  const ts = new Date(record.timestamp || Date.now());
+  return { courseCode: record.courseCode, weekday: ts.getDay(), hour: ts.getHours() };
+};
 
-// Enhanced Authentication Routes
+// Utility function to apply attendance records to the heatmap cube (delta = 1 on insert, -1 on delete)
+const updateAttendanceHeatmap = async (records, delta = 1) => {
+  try {
+    const ops = records
+      .filter(record => ['present', 'late', 'absent', 'excused'].includes(record.status))
+      .map(record => ({
+        updateOne: {
+          filter: heatmapCellFor(record),
+          update: { $inc: { [record.status]: delta } },
+          upsert: true
+        }
+      }));
+    if (ops.length > 0) {
+      await AttendanceHeatmap.bulkWrite(ops, { ordered: false });
+    }
+  } catch (error) {
+    console.error('Error updating attendance heatmap:', error);
+  }
+};
 
-// Admin Registration
-app.post('/api/auth/admin/register', async (req, res) => {
+// Samples are appended atomically and folded into the digest once enough have piled up
+const LATENESS_DIGEST_COMPRESSION = 100;
+const LATENESS_DIGEST_MAX_UNMERGED = 200;
+
+const compactLatenessDigest = async (digestId) => {
+  const doc = await LatenessDigest.findById(digestId).lean();
+  if (!doc) return;
+  const digest = new TDigest(LATENESS_DIGEST_COMPRESSION);
+  digest.merge(doc.centroids);
+  digest.compress();
+  // Only replace the centroids if no sample was pushed meanwhile; otherwise the next push retries
+  await LatenessDigest.updateOne(
+    { _id: doc._id, count: doc.count },
+    { $set: { centroids: digest.centroids, unmerged: 0 } }
+  );
+};
+
+// Utility function to add a lateness sample to the course/day sketch
+const recordLatenessSample = async (courseCode, date, lateMinutes) => {
   try {
-    const { adminName, uniqueId, password, adminLevel, email, phoneNumber } = req.body;
+    const updated = await LatenessDigest.findOneAndUpdate(
+      { courseCode, date },
+      {
+        $push: { centroids: { mean: lateMinutes, count: 1 } },
+        $inc: { count: 1, sum: lateMinutes, unmerged: 1 },
+        $min: { min: lateMinutes },
+        $max: { max: lateMinutes }
+      },
+      { upsert: true, new: true, projection: { unmerged: 1 } }
+    );
+    if (updated.unmerged >= LATENESS_DIGEST_MAX_UNMERGED) {
+      await compactLatenessDigest(updated._id);
+    }
+  } catch (error) {
+    console.error('Error updating lateness digest:', error);
+  }
+};
 
-    if (!adminName || !uniqueId || !password) {
-      return res.status(400).json({
-        success: false,
-        error: 'Admin name, unique ID, and password are required'
+// Live session state for instructor views: one in-memory entry per course for the current day.
+// Opened lazily by the first viewer, updated by the attendance handlers, and served to long-polling
+// viewers from a payload that is serialized once per change rather than once per viewer.
+const liveSessions = new Map();
+const LIVE_STREAM_TIMEOUT_MS = 25000;
+const LIVE_FLUSH_INTERVAL_MS = 250;
+const LIVE_CHANGE_LOG_SIZE = 500;
+
+const liveSessionKey = (courseCode, date) => `${courseCode}|${date}`;
+
+const openLiveSession = async (courseCode) => {
+  const date = new Date().toISOString().split('T')[0];
+  const key = liveSessionKey(courseCode, date);
+  if (liveSessions.has(key)) {
+    return liveSessions.get(key);
+  }
+
+  const loading = (async () => {
+    const course = await Course.findOne({ courseCode, isActive: true }).select('enrolledStudents').lean();
+    if (!course) return null;
+
+    const [students, records] = await Promise.all([
+      User.find({ role: 'student', studentId: { $in: course.enrolledStudents } }).select('studentId studentName').lean(),
+      Attendance.find({ courseCode, date }).select('studentId studentName status timestamp').lean()
+    ]);
+
+    const roster = new Map();
+    students.forEach(student => {
+      roster.set(student.studentId, { studentId: student.studentId, studentName: student.studentName, status: null, timestamp: null });
+    });
+    records.forEach(record => {
+      roster.set(record.studentId, {
+        studentId: record.studentId,
+        studentName: record.studentName,
+        status: record.status,
+        timestamp: record.timestamp
       });
+    });
+
+    const session = {
+      courseCode,
+      date,
+      roster,
+      version: 0,
+      changes: [],
+      snapshotJson: null,
+      changesJson: new Map(),
+      waiters: new Set(),
+      flushTimer: null,
+      closed: false
+    };
+    liveSessions.set(key, session);
+
+    // Sessions from previous days are dropped once a new day's session opens
+    for (const [otherKey, other] of liveSessions) {
+      if (other.date !== date) closeLiveSession(otherKey);
     }
+    return session;
+  })();
 
-    if (password.length < 8) {
+  liveSessions.set(key, loading);
+  try {
+    const session = await loading;
+    if (!session) liveSessions.delete(key);
+    return session;
+  } catch (error) {
+    liveSessions.delete(key);
+    throw error;
+  }
+};
+
+const liveSessionCounts = (session) => {
+  const counts = { enrolled: session.roster.size, present: 0, late: 0, excused: 0, absent: 0, notMarked: 0 };
+  session.roster.forEach(entry => {
+    if (entry.status && counts[entry.status] !== undefined) counts[entry.status]++;
+    else counts.notMarked++;
+  });
+  return counts;
+};
+
+const liveSnapshotJson = (session) => {
+  if (!session.snapshotJson) {
+    session.snapshotJson = JSON.stringify({
+      success: true,
+      data: {
+        courseCode: session.courseCode,
+        date: session.date,
+        version: session.version,
+        closed: session.closed,
+        counts: liveSessionCounts(session),
+        roster: [...session.roster.values()]
+      }
+    });
+  }
+  return session.snapshotJson;
+};
+
+// Changes since a version; falls back to a full snapshot when the viewer is too far behind
+// (or ahead, after the session was reopened)
+const liveChangesJson = (session, since) => {
+  const oldest = session.changes.length > 0 ? session.changes[0].version : session.version + 1;
+  if (since < oldest - 1 || since > session.version) {
+    return liveSnapshotJson(session);
+  }
+  if (!session.changesJson.has(since)) {
+    session.changesJson.set(since, JSON.stringify({
+      success: true,
+      data: {
+        courseCode: session.courseCode,
+        date: session.date,
+        version: session.version,
+        closed: session.closed,
+        counts: liveSessionCounts(session),
+        changes: session.changes.filter(change => change.version > since).map(change => change.entry)
+      }
+    }));
+  }
+  return session.changesJson.get(since);
+};
+
+const flushLiveSession = (session) => {
+  session.flushTimer = null;
+  const waiters = [...session.waiters];
+  session.waiters.clear();
+  waiters.forEach(waiter => waiter(session));
+};
+
+const scheduleLiveFlush = (session) => {
+  session.snapshotJson = null;
+  session.changesJson.clear();
+  if (!session.flushTimer) {
+    session.flushTimer = setTimeout(traceJob('live.flush', () => flushLiveSession(session)), LIVE_FLUSH_INTERVAL_MS);
+  }
+};
+
+const applyLiveAttendance = (attendance) => {
+  const session = liveSessions.get(liveSessionKey(attendance.courseCode, attendance.date));
+  if (!session || session instanceof Promise || session.closed) return;
+
+  const entry = {
+    studentId: attendance.studentId,
+    studentName: attendance.studentName,
+    status: attendance.status,
+    timestamp: attendance.timestamp
+  };
+  session.roster.set(attendance.studentId, entry);
+  session.version++;
+  session.changes.push({ version: session.version, entry });
+  if (session.changes.length > LIVE_CHANGE_LOG_SIZE) session.changes.shift();
+  scheduleLiveFlush(session);
+};
+
+const closeLiveSession = (key) => {
+  const session = liveSessions.get(key);
+  liveSessions.delete(key);
+  if (!session || session instanceof Promise) return;
+  session.closed = true;
+  session.version++;
+  scheduleLiveFlush(session);
+};
+
+// Utility function to advance a student's streak for one session (O(1), single update)
+const updateAttendanceStreak = async (attendance) => {
+  try {
+    const attended = attendance.status === 'present' || attendance.status === 'late';
+    const stages = [{
+      $set: {
+        currentStreak: { $ifNull: ['$currentStreak', 0] },
+        bestStreak: { $ifNull: ['$bestStreak', 0] },
+        lastSessionDate: attendance.date,
+        updatedAt: '$$NOW'
+      }
+    }];
+    if (attended) {
+      stages.push(
+        { $set: { currentStreak: { $add: ['$currentStreak', 1] }, lastAttendedDate: attendance.date } },
+        { $set: { bestStreak: { $max: ['$bestStreak', '$currentStreak'] } } }
+      );
+    } else if (attendance.status === 'absent') {
+      stages.push({ $set: { currentStreak: 0 } });
+    }
+    await StudentSummary.updateOne(
+      { studentId: attendance.studentId, courseCode: attendance.courseCode },
+      stages,
+      { upsert: true }
+    );
+  } catch (error) {
+    console.error('Error updating attendance streak:', error);
+  }
+};
+
+// Close out a course session: every enrolled student who did not attend loses their current streak.
+// The session is claimed in SessionCloseOut first, so repeated or concurrent close-outs of the same
+// date process its absentees once.
+const closeOutCourseSession = async (courseCode, date) => {
+  closeLiveSession(liveSessionKey(courseCode, date));
+  const claim = await SessionCloseOut.updateOne(
+    { courseCode, date },
+    { $setOnInsert: { courseCode, date, closedAt: new Date() } },
+    { upsert: true }
+  );
+  if (claim.upsertedCount === 0) {
+    return { courseCode, date, absentees: 0, alreadyClosed: true };
+  }
+
+  try {
+    return await processSessionAbsentees(courseCode, date);
+  } catch (error) {
+    await SessionCloseOut.deleteOne({ courseCode, date });
+    throw error;
+  }
+};
+
+// Heatmap cell of a session: where most of its attendance landed, else the 9:00 class start
+const sessionHeatmapCell = (courseCode, date, records) => {
+  const counts = new Map();
+  let best = null;
+  records.forEach(record => {
+    const cell = heatmapCellFor(record);
+    const key = cell.weekday * 24 + cell.hour;
+    counts.set(key, (counts.get(key) || 0) + 1);
+    if (!best || counts.get(key) > counts.get(best.weekday * 24 + best.hour)) best = cell;
+  });
+  return best || heatmapCellFor({ courseCode, timestamp: new Date(`${date}T09:00:00`) });
+};
+
+const processSessionAbsentees = async (courseCode, date) => {
+  const course = await Course.findOne({ courseCode }).select('enrolledStudents').lean();
+  const roster = course?.enrolledStudents || [];
+  const records = await Attendance.find({
+    courseCode,
+    date,
+    status: { $in: ['present', 'late', 'excused'] }
+  }).select('studentId timestamp').lean();
+  const markedSet = new Set(records.map(record => record.studentId));
+  const absentees = roster.filter(studentId => !markedSet.has(studentId));
+  if (absentees.length === 0) {
+    return { courseCode, date, absentees: 0 };
+  }
+
+  // Absentees have no record of their own; they count against the session's heatmap cell
+  const cell = sessionHeatmapCell(courseCode, date, records);
+  await AttendanceHeatmap.updateOne(cell, { $inc: { absent: absentees.length } }, { upsert: true });
+
+  // Students whose last session is this date or later (e.g. they attended today) keep their streak
+  await StudentSummary.updateMany(
+    { courseCode, studentId: { $in: absentees }, $or: [{ lastSessionDate: { $lt: date } }, { lastSessionDate: null }] },
+    { $set: { currentStreak: 0, lastSessionDate: date, updatedAt: new Date() } }
+  );
+
+  const existing = await StudentSummary.distinct('studentId', { courseCode, studentId: { $in: absentees } });
+  const existingSet = new Set(existing);
+  const missing = absentees.filter(studentId => !existingSet.has(studentId));
+  if (missing.length > 0) {
+    await StudentSummary.insertMany(
+      missing.map(studentId => ({ studentId, courseCode, currentStreak: 0, bestStreak: 0, lastSessionDate: date })),
+      { ordered: false }
+    ).catch(error => {
+      if (error.code !== 11000) throw error;
+    });
+  }
+
+  await SessionCloseOut.updateOne(
+    { courseCode, date },
+    { $set: { absentees: absentees.length, weekday: cell.weekday, hour: cell.hour } }
+  );
+  bumpVersion('streaks', 'attendance');
+  return { courseCode, date, absentees: absentees.length };
+};
+
+// Recompute streaks for a course in one pass over its attendance ordered by session date
+const backfillCourseStreaks = async (courseCode) => {
+  const course = await Course.findOne({ courseCode }).select('enrolledStudents').lean();
+  const today = new Date().toISOString().split('T')[0];
+  const states = new Map();
+  const stateFor = (studentId) => {
+    if (!states.has(studentId)) {
+      states.set(studentId, { currentStreak: 0, bestStreak: 0, lastSessionDate: null, lastAttendedDate: null });
+    }
+    return states.get(studentId);
+  };
+  (course?.enrolledStudents || []).forEach(stateFor);
+
+  let sessionDate = null;
+  let sessionMarked = new Set();
+  const closeSession = () => {
+    if (!sessionDate || sessionDate >= today) return;
+    states.forEach((state, studentId) => {
+      if (!sessionMarked.has(studentId)) {
+        state.currentStreak = 0;
+        state.lastSessionDate = sessionDate;
+      }
+    });
+  };
+
+  const cursor = Attendance.find({ courseCode })
+    .select('studentId date status')
+    .sort({ date: 1 })
+    .lean()
+    .cursor();
+  for await (const record of cursor) {
+    if (record.date !== sessionDate) {
+      closeSession();
+      sessionDate = record.date;
+      sessionMarked = new Set();
+    }
+    const state = stateFor(record.studentId);
+    state.lastSessionDate = record.date;
+    if (record.status === 'present' || record.status === 'late') {
+      state.currentStreak++;
+      state.bestStreak = Math.max(state.bestStreak, state.currentStreak);
+      state.lastAttendedDate = record.date;
+      sessionMarked.add(record.studentId);
+    } else if (record.status === 'excused') {
+      sessionMarked.add(record.studentId);
+    } else {
+      state.currentStreak = 0;
+    }
+  }
+  closeSession();
+
+  const ops = [...states.entries()].map(([studentId, state]) => ({
+    updateOne: {
+      filter: { studentId, courseCode },
+      update: { $set: { ...state, updatedAt: new Date() } },
+      upsert: true
+    }
+  }));
+  if (ops.length > 0) {
+    await StudentSummary.bulkWrite(ops, { ordered: false });
+  }
+  bumpVersion('streaks');
+  return { courseCode, students: ops.length };
+};
+
+const backfillAttendanceStreaks = async () => {
+  const courseCodes = await Attendance.distinct('courseCode');
+  const results = [];
+  for (const courseCode of courseCodes) {
+    results.push(await backfillCourseStreaks(courseCode));
+  }
+  return results;
+};
+
+// Material search index (rebuilt from MongoDB and the stored files at startup)
+const materialSearchIndex = new MaterialSearchIndex();
+const SEARCH_COMPACTION_INTERVAL_MS = 60 * 1000;
+
+// Index metadata immediately; file text follows once extracted
+const indexMaterial = async (material) => {
+  if (!material.isActive) {
+    materialSearchIndex.remove(material._id);
+    return;
+  }
+  materialSearchIndex.add(material);
+  if (hasMaterialFile(material)) {
+    const bodyText = await extractMaterialText(material);
+    if (bodyText && materialSearchIndex.docs.has(String(material._id))) {
+      materialSearchIndex.add(material, bodyText);
+    }
+  }
+};
+
+// Side effects of a newly stored attendance record. Versions are bumped only after the derived
+// data is written, so a conditional GET never pairs the new ETag with the old aggregates.
+const onAttendanceRecorded = async (attendance) => {
+  try {
+    await updateAttendanceHeatmap([attendance]);
+    await updateAttendanceStreak(attendance);
+    applyLiveAttendance(attendance);
+    if (attendance.isLate && attendance.lateMinutes > 0) {
+      await recordLatenessSample(attendance.courseCode, attendance.date, attendance.lateMinutes);
+    }
+  } finally {
+    bumpVersion('attendance', `attendance:${attendance.studentId}`);
+  }
+};
+
+// Request validation. Each route's body is described once below; at startup every description is
+// compiled into a straight-line validator with new Function, so a request pays for a few typeof
+// checks rather than a walk over the schema. Validators coerce (trim, upper-case, numeric strings
+// to numbers), drop undeclared fields, and report the first problem as { success: false, error }.
+const describeField = (name) => JSON.stringify(name);
+
+const compileFieldCheck = (name, spec, nested) => {
+  const key = describeField(name);
+  const missing = JSON.stringify(spec.message || `${name} is required`);
+  const invalid = JSON.stringify(spec.message || `${name} is invalid`);
+  const lines = [`v = input[${key}];`];
+
+  lines.push(`if (v === undefined || v === null || v === '') {`);
+  lines.push(spec.required ? `  return { error: ${missing} };` : (spec.default !== undefined ? `  out[${key}] = ${JSON.stringify(spec.default)};` : ''));
+  lines.push('} else {');
+
+  switch (spec.type) {
+    case 'string':
+      lines.push(`  if (typeof v !== 'string') return { error: ${invalid} };`);
+      if (spec.trim !== false) lines.push('  v = v.trim();');
+      if (spec.uppercase) lines.push('  v = v.toUpperCase();');
+      if (spec.required) lines.push(`  if (v.length === 0) return { error: ${missing} };`);
+      if (spec.minLength) lines.push(`  if (v.length < ${spec.minLength}) return { error: ${JSON.stringify(spec.lengthMessage || `${name} must be at least ${spec.minLength} characters long`)} };`);
+      if (spec.maxLength) lines.push(`  if (v.length > ${spec.maxLength}) return { error: ${JSON.stringify(`${name} must be at most ${spec.maxLength} characters long`)} };`);
+      if (spec.pattern) lines.push(`  if (!${spec.pattern}.test(v)) return { error: ${invalid} };`);
+      if (spec.enum) lines.push(`  if (!${JSON.stringify(spec.enum)}.includes(v)) return { error: ${invalid} };`);
+      break;
+    case 'number':
+      lines.push(`  if (typeof v === 'string' && v.trim() !== '') v = Number(v);`);
+      lines.push(`  if (typeof v !== 'number' || !Number.isFinite(v)) return { error: ${invalid} };`);
+      if (spec.integer) lines.push(`  if (!Number.isInteger(v)) return { error: ${invalid} };`);
+      if (spec.min !== undefined) lines.push(`  if (v < ${spec.min}) return { error: ${invalid} };`);
+      if (spec.max !== undefined) lines.push(`  if (v > ${spec.max}) return { error: ${invalid} };`);
+      break;
+    case 'boolean':
+      lines.push(`  if (v === 'true') v = true; else if (v === 'false') v = false;`);
+      lines.push(`  if (typeof v !== 'boolean') return { error: ${invalid} };`);
+      break;
+    case 'array':
+      lines.push(`  if (!Array.isArray(v)) return { error: ${invalid} };`);
+      if (spec.minItems !== undefined) lines.push(`  if (v.length < ${spec.minItems}) return { error: ${invalid} };`);
+      if (spec.maxItems !== undefined) lines.push(`  if (v.length > ${spec.maxItems}) return { error: ${invalid} };`);
+      if (spec.items === 'number') {
+        lines.push('  const items = v;');
+        lines.push('  for (let i = 0; i < items.length; i++) {');
+        lines.push(`    if (typeof items[i] !== 'number' || !Number.isFinite(items[i])) return { error: ${invalid} };`);
+        lines.push('  }');
+      } else if (spec.items === 'string') {
+        lines.push('  const items = new Array(v.length);');
+        lines.push(`  for (let i = 0; i < v.length; i++) {`);
+        lines.push(`    if (typeof v[i] !== 'string') return { error: ${invalid} };`);
+        lines.push(spec.uppercase ? '    items[i] = v[i].trim().toUpperCase();' : '    items[i] = v[i].trim();');
+        lines.push('  }');
+        lines.push('  v = items;');
+      }
+      break;
+    case 'object': {
+      lines.push(`  if (typeof v !== 'object' || Array.isArray(v)) return { error: ${invalid} };`);
+      if (spec.fields) {
+        nested.push(compileBodySchema(spec.fields));
+        lines.push(`  const result = nested[${nested.length - 1}](v);`);
+        lines.push('  if (result.error) return result;');
+        lines.push('  v = result.value;');
+      }
+      break;
+    }
+    default:
+      throw new Error(`Unknown field type ${spec.type} for ${name}`);
+  }
+
+  lines.push(`  out[${key}] = v;`);
+  lines.push('}');
+  return lines.filter(Boolean).join('\n');
+};
+
+const compileBodySchema = (fields) => {
+  const nested = [];
+  const body = [
+    'const out = {};',
+    'let v;',
+    ...Object.entries(fields).map(([name, spec]) => compileFieldCheck(name, spec, nested)),
+    'return { value: out };'
+  ].join('\n');
+  // eslint-disable-next-line no-new-func
+  const validate = new Function('nested', `return function validate(input) {\n${body}\n};`)(nested);
+  return (input) => validate(input && typeof input === 'object' ? input : {});
+};
+
+const BODY_SCHEMAS = {
+  adminRegister: {
+    adminName: { type: 'string', required: true, maxLength: 100, message: 'Admin name, unique ID, and password are required' },
+    uniqueId: { type: 'string', required: true, maxLength: 100, message: 'Admin name, unique ID, and password are required' },
+    password: { type: 'string', required: true, trim: false, minLength: 8, maxLength: 200, message: 'Admin name, unique ID, and password are required', lengthMessage: 'Password must be at least 8 characters long' },
+    adminLevel: { type: 'string', enum: ['super_admin', 'admin', 'teacher'] },
+    email: { type: 'string', maxLength: 200 },
+    phoneNumber: { type: 'string', maxLength: 50 }
+  },
+  adminLogin: {
+    uniqueId: { type: 'string', required: true, maxLength: 100, message: 'Unique ID and password are required' },
+    password: { type: 'string', required: true, trim: false, maxLength: 200, message: 'Unique ID and password are required' }
+  },
+  studentLogin: {
+    studentId: { type: 'string', required: true, maxLength: 100, message: 'Student ID is required' }
+  },
+  faceEncodings: {
+    encodings: { type: 'array', items: 'number', required: true, minItems: 64, maxItems: 1024, message: 'Face encodings must be a numeric array of length between 64 and 1024' }
+  },
+  faceImage: {
+    imageBase64: { type: 'string', required: true, trim: false },
+    captureTier: { type: 'string' }
+  },
+  attendance: {
+    courseCode: { type: 'string', required: true, uppercase: true, maxLength: 50, message: 'Course code is required' },
+    faceData: { type: 'array', items: 'number', maxItems: 1024, message: 'Invalid or missing face data for verification' },
+    location: { type: 'object', fields: { latitude: { type: 'number', min: -90, max: 90 }, longitude: { type: 'number', min: -180, max: 180 } } },
+    notes: { type: 'string', maxLength: 500 }
+  },
+  attendanceImage: {
+    courseCode: { type: 'string', required: true, uppercase: true, maxLength: 50, message: 'Course code is required' },
+    imageBase64: { type: 'string', required: true, trim: false },
+    captureTier: { type: 'string' },
+    location: { type: 'object', fields: { latitude: { type: 'number', min: -90, max: 90 }, longitude: { type: 'number', min: -180, max: 180 } } },
+    notes: { type: 'string', maxLength: 500 }
+  },
+  student: {
+    studentName: { type: 'string', required: true, maxLength: 100, message: 'Student name, ID, and date of birth are required' },
+    studentId: { type: 'string', required: true, maxLength: 100, message: 'Student name, ID, and date of birth are required' },
+    dateOfBirth: { type: 'string', required: true, maxLength: 40, message: 'Student name, ID, and date of birth are required' },
+    enrolledCourses: { type: 'array', items: 'string', uppercase: true, maxItems: 100, default: [] },
+    faceImage: { type: 'string', trim: false },
+    email: { type: 'string', maxLength: 200 },
+    phoneNumber: { type: 'string', maxLength: 50 },
+    address: { type: 'string', maxLength: 500 },
+    emergencyContact: { type: 'object', fields: { name: { type: 'string', maxLength: 100 }, phone: { type: 'string', maxLength: 50 }, relationship: { type: 'string', maxLength: 50 } } },
+    academicYear: { type: 'string', maxLength: 20 },
+    semester: { type: 'string', maxLength: 20 }
+  },
+  course: {
+    courseCode: { type: 'string', required: true, uppercase: true, maxLength: 50, message: 'Course code and name are required' },
+    courseName: { type: 'string', required: true, maxLength: 200, message: 'Course code and name are required' },
+    instructor: { type: 'string', maxLength: 100 },
+    department: { type: 'string', maxLength: 100 },
+    credits: { type: 'number', integer: true, min: 0, max: 30 },
+    description: { type: 'string', maxLength: 2000 },
+    schedule: { type: 'object', fields: { days: { type: 'array', items: 'string', maxItems: 7 }, time: { type: 'string', maxLength: 50 }, room: { type: 'string', maxLength: 50 } } },
+    maxCapacity: { type: 'number', integer: true, min: 1, max: 10000 },
+    semester: { type: 'string', maxLength: 20 },
+    academicYear: { type: 'string', maxLength: 20 }
+  }
+};
+
+const bodyValidators = Object.fromEntries(
+  Object.entries(BODY_SCHEMAS).map(([name, fields]) => [name, compileBodySchema(fields)])
+);
+
+const validateBody = (schemaName) => {
+  const validate = bodyValidators[schemaName];
+  return (req, res, next) => {
+    const result = validate(req.body);
+    if (result.error) {
+      return res.status(400).json({ success: false, error: result.error });
+    }
+    req.body = result.value;
+    next();
+  };
+};
+
+// Enhanced health check endpoint
+app.get('/api/health', (req, res) => {
+  const healthCheck = {
+    success: true,
+    status: 'Server running',
+    timestamp: new Date().toISOString(),
+    environment: process.env.NODE_ENV || 'development',
+    mongodb: mongoose.connection.readyState === 1 ? 'connected' : 'disconnected',
+    uptime: process.uptime(),
+    memory: process.memoryUsage(),
+    load: {
+      eventLoopLagMs: Math.round(eventLoopLagMs),
+      requestsInFlight,
+      upstreamInFlight,
+      pressure: Number(overloadPressure().toFixed(2))
+    },
+    version: '2.0.0'
+  };
+  res.json(healthCheck);
+});
+
+// Metrics
+// Prometheus-style histograms kept in memory; they restart from zero with the server, which scrapers handle
+const METRICS_TOKEN = process.env.METRICS_TOKEN || '';
+const MAX_METRIC_SERIES = 2000;
+const metricCounters = new Map();
+const metricHistograms = new Map();
+
+const incrementCounter = (name, help, labels, amount = 1) => {
+  let counter = metricCounters.get(name);
+  if (!counter) {
+    counter = { help, series: new Map() };
+    metricCounters.set(name, counter);
+  }
+
+  const key = JSON.stringify(labels);
+  const series = counter.series.get(key);
+  if (series) {
+    series.value += amount;
+  } else if (counter.series.size < MAX_METRIC_SERIES) {
+    counter.series.set(key, { labels, value: amount });
+  }
+};
+
+// Record one observation; returns false once a histogram has reached its series limit
+const observeHistogram = (name, help, buckets, labels, value) => {
+  let histogram = metricHistograms.get(name);
+  if (!histogram) {
+    histogram = { help, buckets, series: new Map() };
+    metricHistograms.set(name, histogram);
+  }
+
+  const key = JSON.stringify(labels);
+  let series = histogram.series.get(key);
+  if (!series) {
+    if (histogram.series.size >= MAX_METRIC_SERIES) return false;
+    series = { labels, counts: new Array(buckets.length).fill(0), sum: 0, count: 0 };
+    histogram.series.set(key, series);
+  }
+
+  const bucket = buckets.findIndex(bound => value <= bound);
+  if (bucket !== -1) series.counts[bucket]++;
+  series.sum += value;
+  series.count++;
+  return true;
+};
+
+const formatMetricLabels = (labels) => {
+  const pairs = Object.entries(labels).map(([name, value]) =>
+    `${name}="${String(value).replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n')}"`
+  );
+  return pairs.length > 0 ? `{${pairs.join(',')}}` : '';
+};
+
+// Text exposition format (cumulative histogram buckets)
+const renderMetrics = () => {
+  const lines = [];
+  metricCounters.forEach((counter, name) => {
+    lines.push(`# HELP ${name} ${counter.help}`, `# TYPE ${name} counter`);
+    counter.series.forEach(series => {
+      lines.push(`${name}${formatMetricLabels(series.labels)} ${series.value}`);
+    });
+  });
+  metricHistograms.forEach((histogram, name) => {
+    lines.push(`# HELP ${name} ${histogram.help}`, `# TYPE ${name} histogram`);
+    histogram.series.forEach(series => {
+      let cumulative = 0;
+      histogram.buckets.forEach((bound, i) => {
+        cumulative += series.counts[i];
+        lines.push(`${name}_bucket${formatMetricLabels({ ...series.labels, le: bound })} ${cumulative}`);
+      });
+      lines.push(`${name}_bucket${formatMetricLabels({ ...series.labels, le: '+Inf' })} ${series.count}`);
+      lines.push(`${name}_sum${formatMetricLabels(series.labels)} ${series.sum}`);
+      lines.push(`${name}_count${formatMetricLabels(series.labels)} ${series.count}`);
+    });
+  });
+  return lines.join('\n') + '\n';
+};
+
+// Scrapers authenticate with METRICS_TOKEN; otherwise an admin token is required
+const authenticateMetrics = (req, res, next) => {
+  const token = Buffer.from((req.headers['authorization'] || '').split(' ')[1] || '');
+  const expected = Buffer.from(METRICS_TOKEN);
+  if (METRICS_TOKEN && token.length === expected.length && crypto.timingSafeEqual(token, expected)) {
+    return next();
+  }
+  authenticateToken(req, res, () => requireAdmin(req, res, next));
+};
+
+app.get('/api/metrics', authenticateMetrics, (req, res) => {
+  res.set('Content-Type', 'text/plain; version=0.0.4; charset=utf-8');
+  res.send(renderMetrics());
+});
+
+// Client performance telemetry: the app sends gzip-compressed batches of [flow, mark, ms] samples,
+// where ms is the time from the start of the flow (e.g. opening the attendance camera) to the mark
+const CLIENT_PERF_BUCKETS_MS = [50, 100, 250, 500, 1000, 2000, 3000, 5000, 8000, 13000, 20000, 30000, 60000];
+const MAX_PERF_SAMPLES_PER_BATCH = 1000;
+const MAX_PERF_SAMPLE_MS = 10 * 60 * 1000;
+const PERF_PLATFORMS = ['ios', 'android', 'web'];
+const isPerfName = (value) => typeof value === 'string' && /^[a-z][a-z0-9_]{0,31}$/.test(value);
+const isAppVersion = (value) => typeof value === 'string' && /^[0-9A-Za-z.+-]{1,32}$/.test(value);
+
+app.post('/api/telemetry/perf', authenticateToken, (req, res) => {
+  try {
+    const { appVersion, platform, samples } = req.body;
+
+    if (!isAppVersion(appVersion) || !PERF_PLATFORMS.includes(platform) || !Array.isArray(samples)) {
       return res.status(400).json({
         success: false,
-        error: 'Password must be at least 8 characters long'
+        error: 'appVersion, platform and samples are required'
+      });
+    }
+
+    if (samples.length > MAX_PERF_SAMPLES_PER_BATCH) {
+      return res.status(413).json({
+        success: false,
+        error: `At most ${MAX_PERF_SAMPLES_PER_BATCH} samples per batch`
       });
     }
 
+    let accepted = 0;
+    for (const sample of samples) {
+      if (!Array.isArray(sample)) continue;
+      const [flow, mark, ms] = sample;
+      if (!isPerfName(flow) || !isPerfName(mark) || !Number.isFinite(ms) || ms < 0 || ms > MAX_PERF_SAMPLE_MS) continue;
+
+      const recorded = observeHistogram(
+        'client_flow_mark_ms',
+        'Time from the start of a client flow to each mark, in milliseconds',
+        CLIENT_PERF_BUCKETS_MS,
+        { app_version: appVersion, platform, flow, mark },
+        ms
+      );
+      if (recorded) accepted++;
+    }
+
+    res.json({
+      success: true,
+      data: { accepted, rejected: samples.length - accepted }
+    });
+  } catch (error) {
+    console.error('Telemetry ingest error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to record telemetry'
+    });
+  }
+});
+
+// Enhanced Authentication Routes
+
+// Admin Registration
+app.post('/api/auth/admin/register', validateBody('adminRegister'), async (req, res) => {
+  try {
+    const { adminName, uniqueId, password, adminLevel, email, phoneNumber } = req.body;
+
     const existingAdmin = await User.findOne({ 
       $or: [
         { uniqueId: uniqueId.trim() },
@@ -563,17 +2322,10 @@ app.post('/api/auth/admin/register', async (req, res) => {
 });
 
 // Enhanced Admin Login
-app.post('/api/auth/admin/login', async (req, res) => {
+app.post('/api/auth/admin/login', validateBody('adminLogin'), async (req, res) => {
   try {
     const { uniqueId, password } = req.body;
 
-    if (!uniqueId || !password) {
-      return res.status(400).json({
-        success: false,
-        error: 'Unique ID and password are required'
-      });
-    }
-
     const admin = await User.findOne({ 
       uniqueId: uniqueId.trim(), 
       role: 'admin',
@@ -639,17 +2391,10 @@ app.post('/api/auth/admin/login', async (req, res) => {
 });
 
 // Enhanced Student Login
-app.post('/api/auth/student/login', async (req, res) => {
+app.post('/api/auth/student/login', validateBody('studentLogin'), async (req, res) => {
   try {
     const { studentId } = req.body;
 
-    if (!studentId) {
-      return res.status(400).json({
-        success: false,
-        error: 'Student ID is required'
-      });
-    }
-
     const student = await User.findOne({ 
       studentId: studentId.trim(), 
       role: 'student',
@@ -667,6 +2412,7 @@ app.post('/api/auth/student/login', async (req, res) => {
     student.lastLogin = new Date();
     student.loginCount += 1;
     await student.save();
+    bumpVersion(`user:${student.studentId}`, 'students');
 
     const token = jwt.sign(
       { 
@@ -706,26 +2452,10 @@ app.post('/api/auth/student/login', async (req, res) => {
 });
 
 // Student Face Registration (stores face encodings for the logged-in student)
-app.post('/api/student/face/register', authenticateToken, requireStudent, async (req, res) => {
+app.post('/api/student/face/register', authenticateToken, requireStudent, validateBody('faceEncodings'), async (req, res) => {
   try {
     const { encodings } = req.body;
 
-    if (!encodings || !Array.isArray(encodings) || encodings.length === 0) {
-      return res.status(400).json({
-        success: false,
-        error: 'Valid face encodings array is required'
-      });
-    }
-
-    // Basic validation: ensure numbers and reasonable length (e.g., 64-512 dims)
-    const areNumbers = encodings.every(v => typeof v === 'number' && Number.isFinite(v));
-    if (!areNumbers || encodings.length < 64 || encodings.length > 1024) {
-      return res.status(400).json({
-        success: false,
-        error: 'Face encodings must be a numeric array of length between 64 and 1024'
-      });
-    }
-
     const student = await User.findOne({ studentId: req.user.studentId, role: 'student', isActive: true });
     if (!student) {
       return res.status(404).json({ success: false, error: 'Student not found' });
@@ -733,6 +2463,7 @@ app.post('/api/student/face/register', authenticateToken, requireStudent, async
 
     student.faceEncodings = encodings;
     await student.save();
+    bumpVersion(`user:${student.studentId}`, 'students');
 
     res.json({ success: true, message: 'Face encodings registered successfully' });
   } catch (error) {
@@ -742,13 +2473,14 @@ app.post('/api/student/face/register', authenticateToken, requireStudent, async
 });
 
 // Face encoding endpoint (diagnostics)
-app.post('/api/face/encode', authenticateToken, async (req, res) => {
+app.post('/api/face/encode', authenticateToken, validateBody('faceImage'), async (req, res) => {
   try {
     const { imageBase64 } = req.body;
-    if (!imageBase64) {
-      return res.status(400).json({ success: false, error: 'imageBase64 is required' });
+    const parts = splitImageDataUrl(imageBase64);
+    if (!parts) {
+      return res.status(400).json({ success: false, error: 'imageBase64 is not a valid image' });
     }
-    const embedding = await getEmbeddingFromExternalApi(imageBase64);
+    const embedding = await getEmbeddingFromExternalApi(parts.base64);
     return res.json({ success: true, data: { embedding } });
   } catch (error) {
     console.error('Face encode error:', error.message || error);
@@ -757,17 +2489,19 @@ app.post('/api/face/encode', authenticateToken, async (req, res) => {
 });
 
 // Student Face Registration via image
-app.post('/api/student/face/register-image', authenticateToken, requireStudent, async (req, res) => {
+app.post('/api/student/face/register-image', authenticateToken, requireStudent, validateBody('faceImage'), async (req, res) => {
   try {
     const { imageBase64 } = req.body;
-    if (!imageBase64) {
-      return res.status(400).json({ success: false, error: 'imageBase64 is required' });
+    const image = decodeImagePayload(imageBase64);
+    if (!image) {
+      return res.status(400).json({ success: false, error: 'imageBase64 is not a valid image' });
     }
+    recordCaptureImage('register', normalizeCaptureTier(req.body.captureTier), imageBase64);
 
     // Primary: Face++ token
     let faceToken;
     try {
-      faceToken = await faceppDetectGetToken(imageBase64);
+      faceToken = await faceppDetectGetToken(image);
     } catch (e) {
       return res.status(400).json({ success: false, error: 'Face not detected. Please try again.' });
     }
@@ -779,6 +2513,7 @@ app.post('/api/student/face/register-image', authenticateToken, requireStudent,
 
     student.faceToken = faceToken;
     await student.save();
+    bumpVersion(`user:${student.studentId}`, 'students');
 
     res.json({ success: true, message: 'Face registered successfully' });
   } catch (error) {
@@ -787,20 +2522,43 @@ app.post('/api/student/face/register-image', authenticateToken, requireStudent,
   }
 });
 
+// Capture tiers the app picks per upload from its connection estimate; recorded so match
+// accuracy and image sizes can be compared across tiers
+const CAPTURE_TIERS = ['high', 'medium', 'low', 'minimal'];
+const FACE_SIMILARITY_BUCKETS = [0.5, 0.6, 0.7, 0.8, 0.85, 0.9, 0.95, 0.98, 1];
+const CAPTURE_IMAGE_BUCKETS_KB = [16, 32, 64, 128, 256, 512, 1024];
+const normalizeCaptureTier = (tier) => (CAPTURE_TIERS.includes(tier) ? tier : 'unknown');
+
+const recordCaptureImage = (flow, tier, imageBase64) => {
+  observeHistogram(
+    'capture_image_kb',
+    'Size of face images uploaded by the app (base64), in KB',
+    CAPTURE_IMAGE_BUCKETS_KB,
+    { flow, tier },
+    Math.round(imageBase64.length / 1024)
+  );
+};
+
+const recordFaceMatch = (tier, outcome, similarity) => {
+  incrementCounter('face_match_attempts_total', 'Attendance face matches by capture tier and outcome', { tier, outcome });
+  if (similarity !== undefined) {
+    observeHistogram('face_match_similarity', 'Face++ similarity of attendance captures', FACE_SIMILARITY_BUCKETS, { tier }, similarity);
+  }
+};
+
 // Attendance via image (Face++ compare)
-app.post('/api/student/attendance-image', authenticateToken, requireStudent, async (req, res) => {
+app.post('/api/student/attendance-image', authenticateToken, requireStudent, validateBody('attendanceImage'), async (req, res) => {
   try {
     const { courseCode, imageBase64, location, notes } = req.body;
+    const captureTier = normalizeCaptureTier(req.body.captureTier);
     const studentId = req.user.studentId;
 
-    if (!courseCode) {
-      return res.status(400).json({ success: false, error: 'Course code is required' });
-    }
-    if (!imageBase64) {
-      return res.status(400).json({ success: false, error: 'imageBase64 is required' });
+    const image = decodeImagePayload(imageBase64);
+    if (!image) {
+      return res.status(400).json({ success: false, error: 'imageBase64 is not a valid image' });
     }
 
-    const student = await User.findOne({ studentId: studentId, role: 'student', isActive: true });
+    const student = await findActiveStudent(studentId);
     if (!student) {
       return res.status(404).json({ success: false, error: 'Student not found' });
     }
@@ -808,14 +2566,12 @@ app.post('/api/student/attendance-image', authenticateToken, requireStudent, asy
       return res.status(400).json({ success: false, error: 'You are not enrolled in this course' });
     }
 
-    const course = await Course.findOne({ courseCode: courseCode.toUpperCase(), isActive: true });
-    if (!course) {
+    if (!(await activeCourseExists(courseCode.toUpperCase()))) {
       return res.status(404).json({ success: false, error: 'Course not found' });
     }
 
     const today = new Date().toISOString().split('T')[0];
-    const existingAttendance = await Attendance.findOne({ studentId: studentId, courseCode: courseCode.toUpperCase(), date: today });
-    if (existingAttendance) {
+    if (await attendanceExists(studentId, courseCode.toUpperCase(), today)) {
       return res.status(400).json({ success: false, error: 'Attendance already marked for today in this course' });
     }
 
@@ -823,17 +2579,21 @@ app.post('/api/student/attendance-image', authenticateToken, requireStudent, asy
       return res.status(400).json({ success: false, error: 'No registered face found. Please register your face first.' });
     }
 
+    recordCaptureImage('attendance', captureTier, imageBase64);
     let similarity;
     try {
-      similarity = await faceppCompare(student.faceToken, imageBase64);
+      similarity = await faceppCompare(student.faceToken, image);
     } catch (e) {
+      recordFaceMatch(captureTier, 'error');
       return res.status(400).json({ success: false, error: 'Face verification failed. Please try again.' });
     }
 
     const SIMILARITY_THRESHOLD = 0.85; // 85% confidence
     if (similarity < SIMILARITY_THRESHOLD) {
+      recordFaceMatch(captureTier, 'rejected', similarity);
       return res.status(400).json({ success: false, error: 'Face verification failed. Please try again.' });
     }
+    recordFaceMatch(captureTier, 'matched', similarity);
 
     const currentTime = new Date();
     const classStartTime = new Date();
@@ -851,13 +2611,14 @@ app.post('/api/student/attendance-image', authenticateToken, requireStudent, asy
       }
     }
 
-    const attendance = new Attendance({
+    const savedAttendance = await insertAttendance({
       studentId: studentId,
       studentName: student.studentName,
       courseCode: courseCode.toUpperCase(),
       date: today,
       status: status,
       confidenceScore: similarity,
+      captureTier: captureTier,
       location: location || { latitude: 0, longitude: 0 },
       deviceInfo: req.headers['user-agent'] || 'Unknown Device',
       ipAddress: req.ip || req.connection.remoteAddress,
@@ -866,8 +2627,7 @@ app.post('/api/student/attendance-image', authenticateToken, requireStudent, asy
       isLate: isLate,
       lateMinutes: lateMinutes
     });
-
-    const savedAttendance = await attendance.save();
+    await onAttendanceRecorded(savedAttendance);
 
     if (isLate) {
       await createNotification(studentId, 'Late Attendance Recorded', `You were marked late for ${courseCode} by ${lateMinutes} minutes.`, 'warning', courseCode.toUpperCase());
@@ -890,7 +2650,7 @@ app.post('/api/student/attendance-image', authenticateToken, requireStudent, asy
 });
 
 // Enhanced Student Creation
-app.post('/api/admin/students', authenticateToken, requireAdmin, async (req, res) => {
+app.post('/api/admin/students', authenticateToken, requireAdmin, validateBody('student'), async (req, res) => {
   try {
     const { 
       studentName, 
@@ -906,13 +2666,6 @@ app.post('/api/admin/students', authenticateToken, requireAdmin, async (req, res
       semester
     } = req.body;
 
-    if (!studentName || !studentId || !dateOfBirth) {
-      return res.status(400).json({
-        success: false,
-        error: 'Student name, ID, and date of birth are required'
-      });
-    }
-
     const existingStudent = await User.findOne({ 
       $or: [
         { studentId: studentId.trim() },
@@ -927,7 +2680,7 @@ app.post('/api/admin/students', authenticateToken, requireAdmin, async (req, res
       });
     }
 
-    const coursesToEnroll = enrolledCourses || [];
+    const coursesToEnroll = enrolledCourses;
     if (coursesToEnroll.length > 0) {
       const existingCourses = await Course.find({ 
         courseCode: { $in: coursesToEnroll },
@@ -966,9 +2719,11 @@ app.post('/api/admin/students', authenticateToken, requireAdmin, async (req, res
     // If face image is provided, register it
     if (faceImage) {
       try {
-        // Convert base64 image to buffer and process
-        const base64Data = faceImage.replace(/^data:image\/[a-z]+;base64,/, '');
-        const faceToken = await faceppDetectGetToken(base64Data);
+        const image = decodeImagePayload(faceImage);
+        if (!image) {
+          throw new Error('Face image is not valid base64 image data');
+        }
+        const faceToken = await faceppDetectGetToken(image);
         savedStudent.faceToken = faceToken;
         await savedStudent.save();
       } catch (faceError) {
@@ -984,6 +2739,7 @@ app.post('/api/admin/students', authenticateToken, requireAdmin, async (req, res
         { $addToSet: { enrolledStudents: studentId.trim() } }
       );
     }
+    bumpVersion('students', 'courses', `user:${savedStudent.studentId}`);
 
     // Create welcome notification
     await createNotification(
@@ -1027,10 +2783,63 @@ app.post('/api/admin/students', authenticateToken, requireAdmin, async (req, res
 
 // Material Management Routes
 
+// Material fields shared by the single-request and chunked upload paths
+const buildMaterialData = (body, user) => {
+  const { title, description, courseCode, materialType, tags, publishDate, dueDate } = body;
+  return {
+    title: title.trim(),
+    description: description?.trim(),
+    courseCode: courseCode.toUpperCase(),
+    materialType: materialType || 'document',
+    uploadedBy: user.uniqueId,
+    tags: Array.isArray(tags) ? tags.map(tag => String(tag).trim()) : tags ? tags.split(',').map(tag => tag.trim()) : [],
+    publishDate: publishDate ? new Date(publishDate) : new Date(),
+    dueDate: dueDate ? new Date(dueDate) : null
+  };
+};
+
+// Save a material, refresh caches and the search index, and notify enrolled students
+const publishMaterial = async (materialData) => {
+  if (materialData.filePath) {
+    Object.assign(materialData, await ingestMaterialFile(materialData.filePath));
+    delete materialData.filePath;
+  }
+
+  const isVideo = materialData.materialType === 'video' && materialData.manifest?.length > 0;
+  if (isVideo) {
+    materialData.streaming = { status: 'pending', revision: 1 };
+  }
+
+  const material = new Material(materialData);
+  const savedMaterial = await material.save();
+  bumpMaterialVersions(savedMaterial.courseCode);
+  if (isVideo) queueVideoTranscode(savedMaterial._id);
+  indexMaterial(savedMaterial).catch(error => console.error('Index material error:', error));
+  scheduleMaterialPublishBump(savedMaterial.courseCode, savedMaterial.publishDate);
+
+  const enrolledStudents = await User.find({ 
+    role: 'student', 
+    enrolledCourses: savedMaterial.courseCode,
+    isActive: true 
+  });
+
+  for (const student of enrolledStudents) {
+    await createNotification(
+      student.studentId,
+      'New Material Available',
+      `New material "${savedMaterial.title}" has been uploaded for ${savedMaterial.courseCode}`,
+      'info',
+      savedMaterial.courseCode
+    );
+  }
+
+  return savedMaterial;
+};
+
 // Upload Material
 app.post('/api/admin/materials', authenticateToken, requireAdmin, upload.single('file'), async (req, res) => {
   try {
-    const { title, description, courseCode, materialType, url, tags, publishDate, dueDate } = req.body;
+    const { title, courseCode, url } = req.body;
 
     if (!title || !courseCode) {
       return res.status(400).json({
@@ -1048,45 +2857,19 @@ app.post('/api/admin/materials', authenticateToken, requireAdmin, upload.single(
       });
     }
 
-    let materialData = {
-      title: title.trim(),
-      description: description?.trim(),
-      courseCode: courseCode.toUpperCase(),
-      materialType: materialType || 'document',
-      uploadedBy: req.user.uniqueId,
-      tags: tags ? tags.split(',').map(tag => tag.trim()) : [],
-      publishDate: publishDate ? new Date(publishDate) : new Date(),
-      dueDate: dueDate ? new Date(dueDate) : null
-    };
+    let materialData = buildMaterialData(req.body, req.user);
 
     if (req.file) {
       materialData.filePath = req.file.path;
       materialData.fileName = req.file.originalname;
       materialData.fileSize = req.file.size;
+      materialData.materialType = materialTypeForMime(req.file.mimetype) || materialData.materialType;
     } else if (url) {
       materialData.url = url.trim();
       materialData.materialType = 'link';
     }
 
-    const material = new Material(materialData);
-    const savedMaterial = await material.save();
-
-    // Notify enrolled students
-    const enrolledStudents = await User.find({ 
-      role: 'student', 
-      enrolledCourses: courseCode.toUpperCase(),
-      isActive: true 
-    });
-
-    for (const student of enrolledStudents) {
-      await createNotification(
-        student.studentId,
-        'New Material Available',
-        `New material "${title}" has been uploaded for ${courseCode}`,
-        'info',
-        courseCode.toUpperCase()
-      );
-    }
+    const savedMaterial = await publishMaterial(materialData);
 
     res.status(201).json({
       success: true,
@@ -1103,45 +2886,1264 @@ app.post('/api/admin/materials', authenticateToken, requireAdmin, upload.single(
   }
 });
 
-// Get Materials by Course
-app.get('/api/materials/:courseCode', authenticateToken, async (req, res) => {
-  try {
-    const { courseCode } = req.params;
+// Content-defined chunk store for material files
+// Files are split with a gear rolling hash (FastCDC-style normalized chunking), so an edit only
+// changes the chunks around it and revisions share everything else. Chunks are stored once under
+// uploads/chunks/<aa>/<sha256>; each material version keeps an ordered manifest of { hash, size }.
+const CDC_MIN_SIZE = 8 * 1024;
+const CDC_AVG_SIZE = 32 * 1024;
+const CDC_MAX_SIZE = 128 * 1024;
+const CDC_MASK_SMALL = 0xffff8000 | 0; // 17 bits, used before the average size
+const CDC_MASK_LARGE = 0xfff80000 | 0; // 13 bits, used after it
+// Manifests are sized by the file limit of the material type (videos go up to 500MB)
+const maxManifestChunks = (maxFileSize) => Math.ceil(maxFileSize / CDC_MIN_SIZE);
+const MAX_MANIFEST_CHUNKS = maxManifestChunks(MAX_VIDEO_FILE_SIZE);
+const MANIFEST_BODY_LIMIT = MAX_MANIFEST_CHUNKS * 128; // one { hash, size } entry per chunk
+const chunkStoreDir = path.join(uploadsDir, 'chunks');
+
+// Deterministic gear table (mulberry32); the app computes identical boundaries from the same seed
+const CDC_GEAR = (() => {
+  const table = new Int32Array(256);
+  let seed = 0x9e3779b9;
+  for (let i = 0; i < 256; i++) {
+    seed = (seed + 0x6d2b79f5) | 0;
+    let t = Math.imul(seed ^ (seed >>> 15), seed | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    table[i] = t ^ (t >>> 14);
+  }
+  return table;
+})();
+
+// Length of the chunk starting at `start`; only final once CDC_MAX_SIZE bytes are available or at EOF
+const cdcCut = (bytes, start, end) => {
+  const available = end - start;
+  if (available <= CDC_MIN_SIZE) return available;
+  const normal = Math.min(available, CDC_AVG_SIZE);
+  const limit = Math.min(available, CDC_MAX_SIZE);
+  let hash = 0;
+  let i = CDC_MIN_SIZE;
+  for (; i < normal; i++) {
+    hash = ((hash << 1) + CDC_GEAR[bytes[start + i]]) | 0;
+    if ((hash & CDC_MASK_SMALL) === 0) return i + 1;
+  }
+  for (; i < limit; i++) {
+    hash = ((hash << 1) + CDC_GEAR[bytes[start + i]]) | 0;
+    if ((hash & CDC_MASK_LARGE) === 0) return i + 1;
+  }
+  return limit;
+};
+
+async function* cdcChunks(readable) {
+  let pending = Buffer.alloc(0);
+  for await (const data of readable) {
+    pending = pending.length > 0 ? Buffer.concat([pending, data]) : data;
+    let start = 0;
+    while (pending.length - start >= CDC_MAX_SIZE) {
+      const length = cdcCut(pending, start, pending.length);
+      yield pending.subarray(start, start + length);
+      start += length;
+    }
+    pending = pending.subarray(start);
+  }
+  while (pending.length > 0) {
+    const length = cdcCut(pending, 0, pending.length);
+    yield pending.subarray(0, length);
+    pending = pending.subarray(length);
+  }
+}
+
+const chunkPath = (hash) => path.join(chunkStoreDir, hash.slice(0, 2), hash);
+
+const hasChunk = async (hash, size) => {
+  try {
+    const stats = await fs.promises.stat(chunkPath(hash));
+    return size === undefined || stats.size === size;
+  } catch (error) {
+    return false;
+  }
+};
+
+// Write through a temp file so a crash never leaves a truncated chunk under its final name
+const storeChunk = async (hash, data) => {
+  if (await hasChunk(hash, data.length)) return false;
+  const target = chunkPath(hash);
+  await fs.promises.mkdir(path.dirname(target), { recursive: true });
+  const temp = `${target}.${crypto.randomBytes(6).toString('hex')}.tmp`;
+  await fs.promises.writeFile(temp, data);
+  await fs.promises.rename(temp, target);
+  return true;
+};
+
+// Chunk a file on disk into the store and remove it; returns the manifest fields for the material
+const ingestMaterialFile = async (filePath) => {
+  const manifest = [];
+  const fileHash = crypto.createHash('sha256');
+  let fileSize = 0;
+  for await (const chunk of cdcChunks(fs.createReadStream(filePath))) {
+    const hash = crypto.createHash('sha256').update(chunk).digest('hex');
+    await storeChunk(hash, chunk);
+    manifest.push({ hash, size: chunk.length });
+    fileHash.update(chunk);
+    fileSize += chunk.length;
+  }
+  await fs.promises.unlink(filePath);
+  return { manifest, fileHash: fileHash.digest('hex'), fileSize };
+};
+
+// Check a client-supplied manifest against the store and hash the file it describes
+const verifyManifest = async (chunks, maxFileSize) => {
+  const maxChunks = maxManifestChunks(maxFileSize);
+  if (!Array.isArray(chunks) || chunks.length === 0 || chunks.length > maxChunks) {
+    return { error: 'Manifest must list between 1 and ' + maxChunks + ' chunks' };
+  }
+  const manifest = [];
+  let fileSize = 0;
+  for (const chunk of chunks) {
+    const hash = String(chunk?.hash || '').toLowerCase();
+    const size = Number(chunk?.size);
+    if (!/^[a-f0-9]{64}$/.test(hash) || !Number.isInteger(size) || size <= 0 || size > CDC_MAX_SIZE) {
+      return { error: 'Manifest entries need a sha256 hash and a size up to ' + CDC_MAX_SIZE + ' bytes' };
+    }
+    manifest.push({ hash, size });
+    fileSize += size;
+  }
+  if (fileSize > maxFileSize) {
+    return { error: `File exceeds ${maxFileSize / (1024 * 1024)}MB` };
+  }
+
+  const missing = [];
+  for (const { hash, size } of manifest) {
+    if (!(await hasChunk(hash, size))) missing.push(hash);
+  }
+  if (missing.length > 0) {
+    return { error: `${missing.length} chunks are missing`, missing };
+  }
+
+  const fileHash = crypto.createHash('sha256');
+  for (const { hash } of manifest) {
+    fileHash.update(await fs.promises.readFile(chunkPath(hash)));
+  }
+  return { manifest, fileSize, fileHash: fileHash.digest('hex') };
+};
+
+async function* readManifestChunks(manifest, start = 0, end = Infinity) {
+  let offset = 0;
+  for (const { hash, size } of manifest) {
+    if (offset + size > start && offset <= end) {
+      const data = await fs.promises.readFile(chunkPath(hash));
+      yield data.subarray(Math.max(0, start - offset), Math.min(size, end - offset + 1));
+    }
+    offset += size;
+    if (offset > end) break;
+  }
+}
+
+const hasMaterialFile = (material) => (material.manifest?.length || 0) > 0 || Boolean(material.filePath);
+
+// File contents (at most maxBytes), from the chunk manifest or from a legacy single-file upload;
+// chunks past the limit are never read
+const readMaterialFile = async (material, maxBytes = Infinity) => {
+  if (material.manifest?.length > 0) {
+    const buffers = [];
+    let total = 0;
+    for (const { hash } of material.manifest) {
+      if (total >= maxBytes) break;
+      const chunk = await fs.promises.readFile(chunkPath(hash));
+      buffers.push(chunk);
+      total += chunk.length;
+    }
+    const contents = Buffer.concat(buffers);
+    return contents.length > maxBytes ? contents.subarray(0, maxBytes) : contents;
+  }
+  if (material.filePath && fs.existsSync(material.filePath)) {
+    if (maxBytes === Infinity) return fs.promises.readFile(material.filePath);
+    const handle = await fs.promises.open(material.filePath, 'r');
+    try {
+      const { size } = await handle.stat();
+      const buffer = Buffer.alloc(Math.min(size, maxBytes));
+      const { bytesRead } = await handle.read(buffer, 0, buffer.length, 0);
+      return buffer.subarray(0, bytesRead);
+    } finally {
+      await handle.close();
+    }
+  }
+  return null;
+};
+
+// Remove chunks no material version references, once they are old enough not to belong to an upload in progress
+const sweepUnreferencedChunks = async () => {
+  try {
+    const referenced = new Set();
+    const materials = await Material.find({}).select('+manifest +revisions').lean();
+    materials.forEach(material => {
+      (material.manifest || []).forEach(chunk => referenced.add(chunk.hash));
+      (material.revisions || []).forEach(revision => (revision.manifest || []).forEach(chunk => referenced.add(chunk.hash)));
+    });
+
+    const cutoff = Date.now() - UPLOAD_SESSION_TTL_MS;
+    let removed = 0;
+    const prefixes = await fs.promises.readdir(chunkStoreDir).catch(() => []);
+    for (const prefix of prefixes) {
+      const names = await fs.promises.readdir(path.join(chunkStoreDir, prefix)).catch(() => []);
+      for (const name of names) {
+        if (referenced.has(name)) continue;
+        const filePath = path.join(chunkStoreDir, prefix, name);
+        const stats = await fs.promises.stat(filePath).catch(() => null);
+        if (stats && stats.mtimeMs < cutoff) {
+          await fs.promises.unlink(filePath).catch(() => {});
+          removed++;
+        }
+      }
+    }
+    if (removed > 0) {
+      console.log(`🧹 Removed ${removed} unreferenced material chunks`);
+    }
+  } catch (error) {
+    console.error('❌ Error sweeping material chunks:', error.message);
+  }
+};
+
+// Missing Chunks (the uploader sends only what the store lacks)
+app.post('/api/admin/materials/chunks/missing', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const { hashes } = req.body;
+
+    if (!Array.isArray(hashes) || hashes.length > MAX_MANIFEST_CHUNKS) {
+      return res.status(400).json({
+        success: false,
+        error: `hashes must be an array of at most ${MAX_MANIFEST_CHUNKS} sha256 digests`
+      });
+    }
+
+    const missing = [];
+    for (const hash of new Set(hashes.map(hash => String(hash).toLowerCase()))) {
+      if (!/^[a-f0-9]{64}$/.test(hash) || !(await hasChunk(hash))) {
+        missing.push(hash);
+      }
+    }
+
+    res.json({
+      success: true,
+      data: { missing }
+    });
+
+  } catch (error) {
+    console.error('Missing chunks error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to check chunks'
+    });
+  }
+});
+
+// Upload Content-Addressed Chunk (raw bytes, or base64 text with X-Chunk-Encoding: base64)
+const CDC_CHUNK_BODY_LIMIT = Math.ceil(CDC_MAX_SIZE * 4 / 3) + 1024;
+
+app.put('/api/admin/materials/chunks/:hash', authenticateToken, requireAdmin,
+  express.raw({ type: () => true, limit: CDC_CHUNK_BODY_LIMIT }), async (req, res) => {
+  try {
+    const hash = req.params.hash.toLowerCase();
+    if (!/^[a-f0-9]{64}$/.test(hash)) {
+      return res.status(400).json({
+        success: false,
+        error: 'Chunk hash must be a sha256 hex digest'
+      });
+    }
+
+    const body = Buffer.isBuffer(req.body) ? req.body : Buffer.alloc(0);
+    const chunk = req.get('X-Chunk-Encoding') === 'base64'
+      ? Buffer.from(body.toString('latin1'), 'base64')
+      : body;
+
+    if (chunk.length === 0 || chunk.length > CDC_MAX_SIZE) {
+      return res.status(422).json({
+        success: false,
+        error: `Chunks must be between 1 and ${CDC_MAX_SIZE} bytes`
+      });
+    }
+
+    if (crypto.createHash('sha256').update(chunk).digest('hex') !== hash) {
+      return res.status(422).json({
+        success: false,
+        error: 'Chunk content does not match its hash'
+      });
+    }
+
+    const stored = await storeChunk(hash, chunk);
+
+    res.status(stored ? 201 : 200).json({
+      success: true,
+      data: { hash, size: chunk.length, stored }
+    });
+
+  } catch (error) {
+    console.error('Upload content chunk error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to store chunk'
+    });
+  }
+});
+
+// Upload Material Revision (a new file version assembled from stored chunks)
+app.post('/api/admin/materials/:id/revisions', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const { fileName, mimeType, chunks } = req.body;
+
+    if (!fileName) {
+      return res.status(400).json({
+        success: false,
+        error: 'File name is required'
+      });
+    }
+
+    if (mimeType && !ALLOWED_MATERIAL_TYPES.includes(mimeType)) {
+      return res.status(400).json({
+        success: false,
+        error: 'Invalid file type. Only images, PDFs, documents and videos are allowed.'
+      });
+    }
+
+    const material = await Material.findById(req.params.id).select('+manifest +revisions');
+    if (!material || !material.isActive) {
+      return res.status(404).json({
+        success: false,
+        error: 'Material not found'
+      });
+    }
+
+    const maxFileSize = material.materialType === 'video' || isVideoType(mimeType) ? MAX_VIDEO_FILE_SIZE : MAX_MATERIAL_FILE_SIZE;
+    const verified = await verifyManifest(chunks, maxFileSize);
+    if (verified.error) {
+      return res.status(verified.missing ? 409 : 400).json({
+        success: false,
+        error: verified.error,
+        ...(verified.missing && { data: { missing: verified.missing } })
+      });
+    }
+
+    if (hasMaterialFile(material)) {
+      material.revisions.push({
+        revision: material.revision,
+        fileName: material.fileName,
+        fileSize: material.fileSize,
+        fileHash: material.fileHash,
+        filePath: material.filePath,
+        manifest: material.manifest,
+        uploadedBy: material.uploadedBy,
+        uploadedAt: material.updatedAt
+      });
+    }
+
+    const previousHashes = new Set(material.manifest.map(chunk => chunk.hash));
+    material.revision += 1;
+    material.fileName = path.basename(String(fileName));
+    material.fileSize = verified.fileSize;
+    material.fileHash = verified.fileHash;
+    material.manifest = verified.manifest;
+    material.filePath = undefined;
+    material.uploadedBy = req.user.uniqueId;
+    material.updatedAt = new Date();
+    if (material.materialType === 'video') {
+      material.streaming = { status: 'pending', revision: material.revision };
+    }
+    await material.save();
+
+    bumpMaterialVersions(material.courseCode);
+    indexMaterial(material).catch(error => console.error('Index material error:', error));
+    if (material.materialType === 'video') queueVideoTranscode(material._id);
+
+    const enrolledStudents = await User.find({
+      role: 'student',
+      enrolledCourses: material.courseCode,
+      isActive: true
+    });
+
+    for (const student of enrolledStudents) {
+      await createNotification(
+        student.studentId,
+        'Material Updated',
+        `"${material.title}" has been updated for ${material.courseCode}`,
+        'info',
+        material.courseCode
+      );
+    }
+
+    const sharedBytes = verified.manifest
+      .filter(chunk => previousHashes.has(chunk.hash))
+      .reduce((total, chunk) => total + chunk.size, 0);
+
+    res.status(201).json({
+      success: true,
+      message: 'Material revision uploaded successfully',
+      data: {
+        _id: material._id,
+        revision: material.revision,
+        fileName: material.fileName,
+        fileSize: material.fileSize,
+        fileHash: material.fileHash,
+        chunkCount: material.manifest.length,
+        sharedBytes
+      }
+    });
+
+  } catch (error) {
+    console.error('Upload material revision error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to upload material revision'
+    });
+  }
+});
+
+// Segmented streaming for video materials
+// Uploaded videos are transcoded in the background with a local ffmpeg into HLS: a 2s first
+// segment followed by 4s segments at up to two bitrates, under uploads/hls/<materialId>/r<revision>.
+// A revision's directory never changes once written, so every file in it is served as immutable.
+const FFMPEG_PATH = process.env.FFMPEG_PATH || 'ffmpeg';
+const FFPROBE_PATH = process.env.FFPROBE_PATH || 'ffprobe';
+const hlsDir = path.join(uploadsDir, 'hls');
+const VIDEO_RENDITIONS = [
+  { name: '720p', height: 720, videoBitrate: 2500000, audioBitrate: 128000 },
+  { name: '360p', height: 360, videoBitrate: 800000, audioBitrate: 96000 }
+];
+let videoTranscodeChain = Promise.resolve();
+
+const probeVideo = async (sourcePath) => {
+  const { stdout } = await execFileAsync(FFPROBE_PATH, [
+    '-v', 'error',
+    '-show_entries', 'stream=codec_type,height:format=duration',
+    '-of', 'json',
+    sourcePath
+  ]);
+  const info = JSON.parse(stdout);
+  const video = (info.streams || []).find(stream => stream.codec_type === 'video');
+  if (!video) throw new Error('File has no video stream');
+  return {
+    height: video.height,
+    hasAudio: (info.streams || []).some(stream => stream.codec_type === 'audio'),
+    durationSeconds: Math.round(Number(info.format?.duration) || 0)
+  };
+};
+
+// Renditions no taller than the source; a small source gets a single rendition at its own height
+const selectRenditions = (sourceHeight) => {
+  const renditions = VIDEO_RENDITIONS.filter(rendition => rendition.height <= sourceHeight);
+  if (renditions.length > 0) return renditions;
+  const smallest = VIDEO_RENDITIONS[VIDEO_RENDITIONS.length - 1];
+  const height = sourceHeight - (sourceHeight % 2);
+  return [{ ...smallest, name: `${height}p`, height }];
+};
+
+const buildHlsArgs = (sourcePath, outputDir, renditions, hasAudio) => {
+  const split = renditions.map((rendition, i) => `[v${i}]`).join('');
+  const scales = renditions.map((rendition, i) => `[v${i}]scale=-2:${rendition.height}[v${i}out]`);
+  const args = [
+    '-y', '-loglevel', 'error', '-i', sourcePath,
+    '-filter_complex', [`[0:v]split=${renditions.length}${split}`, ...scales].join(';')
+  ];
+  renditions.forEach((rendition, i) => {
+    args.push(
+      '-map', `[v${i}out]`,
+      `-c:v:${i}`, 'libx264',
+      `-b:v:${i}`, String(rendition.videoBitrate),
+      `-maxrate:v:${i}`, String(Math.round(rendition.videoBitrate * 1.1)),
+      `-bufsize:v:${i}`, String(rendition.videoBitrate * 2)
+    );
+    if (hasAudio) {
+      args.push('-map', 'a:0', `-c:a:${i}`, 'aac', `-b:a:${i}`, String(rendition.audioBitrate), '-ac', '2');
+    }
+  });
+  args.push(
+    '-preset', 'veryfast',
+    '-sc_threshold', '0',
+    '-force_key_frames', 'expr:gte(t,n_forced*2)',
+    '-f', 'hls',
+    '-hls_init_time', '2',
+    '-hls_time', '4',
+    '-hls_playlist_type', 'vod',
+    '-hls_flags', 'independent_segments',
+    '-hls_segment_filename', path.join(outputDir, '%v', 'segment_%03d.ts'),
+    '-master_pl_name', 'master.m3u8',
+    '-var_stream_map', renditions.map((rendition, i) => `v:${i}${hasAudio ? `,a:${i}` : ''},name:${rendition.name}`).join(' '),
+    path.join(outputDir, '%v', 'index.m3u8')
+  );
+  return args;
+};
+
+const transcodeVideoMaterial = async (materialId) => {
+  const material = await Material.findById(materialId).select('+manifest');
+  if (!material || !material.isActive || material.materialType !== 'video' || !hasMaterialFile(material)) return;
+
+  const revision = material.revision;
+  const materialDir = path.join(hlsDir, String(material._id));
+  const outputDir = path.join(materialDir, `r${revision}`);
+  const sourcePath = material.manifest.length > 0 ? path.join(materialDir, `source-r${revision}.tmp`) : material.filePath;
+  const setStreaming = (streaming) => Material.updateOne(
+    { _id: material._id, revision },
+    { $set: { streaming: { revision, ...streaming } } }
+  );
+
+  try {
+    await setStreaming({ status: 'processing' });
+    await fs.promises.rm(outputDir, { recursive: true, force: true });
+    await fs.promises.mkdir(outputDir, { recursive: true });
+    if (material.manifest.length > 0) {
+      await pipeline(Readable.from(readManifestChunks(material.manifest)), fs.createWriteStream(sourcePath));
+    }
+
+    const { height, hasAudio, durationSeconds } = await probeVideo(sourcePath);
+    const renditions = selectRenditions(height);
+    await execFileAsync(FFMPEG_PATH, buildHlsArgs(sourcePath, outputDir, renditions, hasAudio), { maxBuffer: 16 * 1024 * 1024 });
+
+    await setStreaming({
+      status: 'ready',
+      durationSeconds,
+      renditions: renditions.map(({ name, height, videoBitrate, audioBitrate }) => ({
+        name,
+        height,
+        bandwidth: videoBitrate + (hasAudio ? audioBitrate : 0)
+      }))
+    });
+    bumpMaterialVersions(material.courseCode);
+
+    // Earlier revisions are no longer listed anywhere
+    const entries = await fs.promises.readdir(materialDir);
+    for (const entry of entries) {
+      if (/^r\d+$/.test(entry) && entry !== `r${revision}`) {
+        await fs.promises.rm(path.join(materialDir, entry), { recursive: true, force: true });
+      }
+    }
+    console.log(`🎬 Transcoded video material ${material._id} (r${revision}, ${renditions.map(r => r.name).join('/')})`);
+  } catch (error) {
+    console.error(`❌ Video transcode failed for ${material._id}:`, error.message);
+    await setStreaming({ status: 'failed', error: error.code === 'ENOENT' ? 'ffmpeg is not installed on the server' : 'Transcoding failed' })
+      .catch(() => {});
+    await fs.promises.rm(outputDir, { recursive: true, force: true }).catch(() => {});
+  } finally {
+    if (sourcePath !== material.filePath) {
+      await fs.promises.unlink(sourcePath).catch(() => {});
+    }
+  }
+};
+
+// Transcodes are CPU-heavy, so they run one at a time
+const queueVideoTranscode = (materialId) => {
+  videoTranscodeChain = videoTranscodeChain
+    .then(() => transcodeVideoMaterial(materialId))
+    .catch(error => console.error('Video transcode queue error:', error));
+};
+
+// Resumable chunked material uploads
+// A session is validated up front, then fixed-size chunks arrive in any order into a preallocated
+// file under uploads/incoming/<uploadId>; meta.json tracks which chunks have landed so an upload
+// survives both dropped connections and server restarts.
+const UPLOAD_CHUNK_SIZE = 1024 * 1024;
+const UPLOAD_SESSION_TTL_MS = 24 * 60 * 60 * 1000;
+const incomingUploadsDir = path.join(uploadsDir, 'incoming');
+const uploadSessions = new Map();
+const uploadSessionWrites = new Map();
+
+const CRC32_TABLE = (() => {
+  const table = new Int32Array(256);
+  for (let n = 0; n < 256; n++) {
+    let c = n;
+    for (let k = 0; k < 8; k++) {
+      c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+    }
+    table[n] = c;
+  }
+  return table;
+})();
+
+const crc32 = (buffer) => {
+  let crc = -1;
+  for (let i = 0; i < buffer.length; i++) {
+    crc = CRC32_TABLE[(crc ^ buffer[i]) & 0xff] ^ (crc >>> 8);
+  }
+  return ((crc ^ -1) >>> 0).toString(16).padStart(8, '0');
+};
+
+const uploadSessionDir = (uploadId) => path.join(incomingUploadsDir, uploadId);
+
+const uploadSessionStatus = (session) => ({
+  uploadId: session.uploadId,
+  fileName: session.fileName,
+  fileSize: session.fileSize,
+  chunkSize: session.chunkSize,
+  totalChunks: session.totalChunks,
+  receivedChunks: [...session.received].sort((a, b) => a - b)
+});
+
+// Serialize meta.json writes per session so concurrent chunks never interleave on disk
+const persistUploadSession = (session) => {
+  const metaPath = path.join(uploadSessionDir(session.uploadId), 'meta.json');
+  const previous = uploadSessionWrites.get(session.uploadId) || Promise.resolve();
+  const next = previous
+    .catch(() => {})
+    .then(() => fs.promises.writeFile(metaPath, JSON.stringify({
+      ...session,
+      received: [...session.received]
+    })));
+  uploadSessionWrites.set(session.uploadId, next);
+  return next;
+};
+
+const loadUploadSession = async (uploadId) => {
+  if (!/^[a-f0-9]{32}$/.test(uploadId)) return null;
+  if (uploadSessions.has(uploadId)) return uploadSessions.get(uploadId);
+
+  try {
+    const meta = JSON.parse(await fs.promises.readFile(path.join(uploadSessionDir(uploadId), 'meta.json'), 'utf8'));
+    const session = { ...meta, received: new Set(meta.received) };
+    uploadSessions.set(uploadId, session);
+    return session;
+  } catch (error) {
+    return null;
+  }
+};
+
+const discardUploadSession = async (uploadId) => {
+  uploadSessions.delete(uploadId);
+  await (uploadSessionWrites.get(uploadId) || Promise.resolve()).catch(() => {});
+  uploadSessionWrites.delete(uploadId);
+  await fs.promises.rm(uploadSessionDir(uploadId), { recursive: true, force: true });
+};
+
+const cleanupStaleUploads = async () => {
+  try {
+    const entries = await fs.promises.readdir(incomingUploadsDir).catch(() => []);
+    const cutoff = Date.now() - UPLOAD_SESSION_TTL_MS;
+    for (const uploadId of entries) {
+      const session = await loadUploadSession(uploadId);
+      if (!session || session.updatedAt < cutoff) {
+        await discardUploadSession(uploadId);
+      }
+    }
+  } catch (error) {
+    console.error('❌ Error cleaning up stale uploads:', error.message);
+  }
+};
+
+// Look up a session owned by the requesting admin, answering 404 otherwise
+const findUploadSession = async (req, res) => {
+  const session = await loadUploadSession(req.params.uploadId);
+  if (!session || session.uploadedBy !== req.user.uniqueId) {
+    res.status(404).json({
+      success: false,
+      error: 'Upload session not found'
+    });
+    return null;
+  }
+  return session;
+};
+
+// Start Chunked Material Upload
+app.post('/api/admin/materials/uploads', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const { title, courseCode, fileName, mimeType, sha256 } = req.body;
+    const fileSize = Number(req.body.fileSize);
+    const maxFileSize = isVideoType(mimeType) ? MAX_VIDEO_FILE_SIZE : MAX_MATERIAL_FILE_SIZE;
+
+    if (!title || !courseCode || !fileName) {
+      return res.status(400).json({
+        success: false,
+        error: 'Title, course code and file name are required'
+      });
+    }
+
+    if (!ALLOWED_MATERIAL_TYPES.includes(mimeType)) {
+      return res.status(400).json({
+        success: false,
+        error: 'Invalid file type. Only images, PDFs, documents and videos are allowed.'
+      });
+    }
+
+    if (!Number.isInteger(fileSize) || fileSize <= 0 || fileSize > maxFileSize) {
+      return res.status(400).json({
+        success: false,
+        error: `File size must be between 1 byte and ${maxFileSize / (1024 * 1024)}MB`
+      });
+    }
+
+    if (sha256 && !/^[a-f0-9]{64}$/i.test(sha256)) {
+      return res.status(400).json({
+        success: false,
+        error: 'sha256 must be a hex digest'
+      });
+    }
+
+    const course = await Course.findOne({ courseCode: courseCode.toUpperCase(), isActive: true });
+    if (!course) {
+      return res.status(404).json({
+        success: false,
+        error: 'Course not found'
+      });
+    }
+
+    const uploadId = crypto.randomBytes(16).toString('hex');
+    const session = {
+      uploadId,
+      uploadedBy: req.user.uniqueId,
+      materialData: {
+        ...buildMaterialData(req.body, req.user),
+        ...(materialTypeForMime(mimeType) && { materialType: materialTypeForMime(mimeType) })
+      },
+      fileName: path.basename(String(fileName)),
+      mimeType,
+      fileSize,
+      sha256: sha256 ? sha256.toLowerCase() : null,
+      chunkSize: UPLOAD_CHUNK_SIZE,
+      totalChunks: Math.ceil(fileSize / UPLOAD_CHUNK_SIZE),
+      received: new Set(),
+      createdAt: Date.now(),
+      updatedAt: Date.now()
+    };
+
+    await fs.promises.mkdir(uploadSessionDir(uploadId), { recursive: true });
+    const handle = await fs.promises.open(path.join(uploadSessionDir(uploadId), 'data.part'), 'w');
+    try {
+      await handle.truncate(fileSize);
+    } finally {
+      await handle.close();
+    }
+    uploadSessions.set(uploadId, session);
+    await persistUploadSession(session);
+
+    res.status(201).json({
+      success: true,
+      data: uploadSessionStatus(session)
+    });
+
+  } catch (error) {
+    console.error('Start chunked upload error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to start upload'
+    });
+  }
+});
+
+// Get Chunked Upload Status (used by clients to resume)
+app.get('/api/admin/materials/uploads/:uploadId', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const session = await findUploadSession(req, res);
+    if (!session) return;
+
+    res.json({
+      success: true,
+      data: uploadSessionStatus(session)
+    });
+
+  } catch (error) {
+    console.error('Get upload status error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch upload status'
+    });
+  }
+});
+
+// Upload Chunk (raw bytes, or base64 text with X-Chunk-Encoding: base64; X-Chunk-Checksum is the CRC32 of the decoded bytes)
+const UPLOAD_CHUNK_BODY_LIMIT = Math.ceil(UPLOAD_CHUNK_SIZE * 4 / 3) + 1024;
+
+app.put('/api/admin/materials/uploads/:uploadId/chunks/:index', authenticateToken, requireAdmin,
+  express.raw({ type: () => true, limit: UPLOAD_CHUNK_BODY_LIMIT }), async (req, res) => {
+  try {
+    const session = await findUploadSession(req, res);
+    if (!session) return;
+
+    const index = Number(req.params.index);
+    if (!Number.isInteger(index) || index < 0 || index >= session.totalChunks) {
+      return res.status(400).json({
+        success: false,
+        error: 'Chunk index out of range'
+      });
+    }
+
+    const body = Buffer.isBuffer(req.body) ? req.body : Buffer.alloc(0);
+    const chunk = req.get('X-Chunk-Encoding') === 'base64'
+      ? Buffer.from(body.toString('latin1'), 'base64')
+      : body;
+    const offset = index * session.chunkSize;
+    const expectedLength = Math.min(session.chunkSize, session.fileSize - offset);
+
+    if (chunk.length !== expectedLength) {
+      return res.status(422).json({
+        success: false,
+        error: `Chunk ${index} must be ${expectedLength} bytes, received ${chunk.length}`
+      });
+    }
+
+    const checksum = (req.get('X-Chunk-Checksum') || '').toLowerCase();
+    if (checksum !== crc32(chunk)) {
+      return res.status(422).json({
+        success: false,
+        error: `Checksum mismatch for chunk ${index}`
+      });
+    }
+
+    const handle = await fs.promises.open(path.join(uploadSessionDir(session.uploadId), 'data.part'), 'r+');
+    try {
+      await handle.write(chunk, 0, chunk.length, offset);
+    } finally {
+      await handle.close();
+    }
+
+    session.received.add(index);
+    session.updatedAt = Date.now();
+    await persistUploadSession(session);
+
+    res.json({
+      success: true,
+      data: {
+        index,
+        receivedCount: session.received.size,
+        totalChunks: session.totalChunks
+      }
+    });
+
+  } catch (error) {
+    console.error('Upload chunk error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to store chunk'
+    });
+  }
+});
+
+// Complete Chunked Upload
+app.post('/api/admin/materials/uploads/:uploadId/complete', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const session = await findUploadSession(req, res);
+    if (!session) return;
+
+    if (session.received.size < session.totalChunks) {
+      const missingChunks = [];
+      for (let i = 0; i < session.totalChunks; i++) {
+        if (!session.received.has(i)) missingChunks.push(i);
+      }
+      return res.status(409).json({
+        success: false,
+        error: `${missingChunks.length} chunks still missing`,
+        data: { missingChunks }
+      });
+    }
+
+    if (session.completing) {
+      return res.status(409).json({
+        success: false,
+        error: 'Upload is already being completed'
+      });
+    }
+    session.completing = true;
+
+    try {
+      const partPath = path.join(uploadSessionDir(session.uploadId), 'data.part');
+      const hash = crypto.createHash('sha256');
+      for await (const data of fs.createReadStream(partPath)) {
+        hash.update(data);
+      }
+      const sha256 = hash.digest('hex');
+
+      if (session.sha256 && session.sha256 !== sha256) {
+        await discardUploadSession(session.uploadId);
+        return res.status(422).json({
+          success: false,
+          error: 'Assembled file does not match the declared sha256; upload discarded'
+        });
+      }
+
+      const savedMaterial = await publishMaterial({
+        ...session.materialData,
+        filePath: partPath,
+        fileName: session.fileName,
+        fileSize: session.fileSize
+      });
+      await discardUploadSession(session.uploadId);
+
+      res.status(201).json({
+        success: true,
+        message: 'Material uploaded successfully',
+        data: { ...savedMaterial.toObject(), sha256 }
+      });
+    } finally {
+      session.completing = false;
+    }
+
+  } catch (error) {
+    console.error('Complete chunked upload error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to complete upload'
+    });
+  }
+});
+
+// Abort Chunked Upload
+app.delete('/api/admin/materials/uploads/:uploadId', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const session = await findUploadSession(req, res);
+    if (!session) return;
+
+    await discardUploadSession(session.uploadId);
+
+    res.json({
+      success: true,
+      message: 'Upload cancelled'
+    });
+
+  } catch (error) {
+    console.error('Abort chunked upload error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to cancel upload'
+    });
+  }
+});
+
+// Search Materials (BM25 over title, description, tags and file text; last term matches as a prefix)
+app.get('/api/materials/search', authenticateToken, async (req, res) => {
+  try {
+    const { q = '', courseCode } = req.query;
+    const limit = Math.min(parseInt(req.query.limit, 10) || 20, 50);
+
+    if (!q.trim()) {
+      return res.status(400).json({
+        success: false,
+        error: 'Search query is required'
+      });
+    }
+
+    let courseCodes = courseCode ? [courseCode.toUpperCase()] : null;
+    let publishedBefore = null;
+    if (req.user.role === 'student') {
+      const student = await User.findOne({ studentId: req.user.studentId, role: 'student' })
+        .select('enrolledCourses')
+        .lean();
+      if (!student) {
+        return res.status(404).json({
+          success: false,
+          error: 'Student not found'
+        });
+      }
+      courseCodes = (courseCodes || student.enrolledCourses).filter(code => student.enrolledCourses.includes(code));
+      publishedBefore = new Date();
+    }
+
+    const hits = materialSearchIndex.search(q, { courseCodes, publishedBefore, limit });
+    const materials = hits.length > 0
+      ? await Material.find({ _id: { $in: hits.map(hit => hit.id) }, isActive: true }).lean()
+      : [];
+    const materialById = new Map(materials.map(material => [String(material._id), material]));
+
+    res.json({
+      success: true,
+      data: {
+        query: q,
+        results: hits
+          .filter(hit => materialById.has(hit.id))
+          .map(hit => ({ ...materialById.get(hit.id), score: Math.round(hit.score * 1000) / 1000 }))
+      }
+    });
+
+  } catch (error) {
+    console.error('Search materials error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to search materials'
+    });
+  }
+});
+
+// Get Materials by Course
+app.get('/api/materials/:courseCode', authenticateToken, conditionalGet(req => [`materials:${req.params.courseCode.toUpperCase()}`]), async (req, res) => {
+  try {
+    const { courseCode } = req.params;
     const { page = 1, limit = 20 } = req.query;
 
-    const materials = await Material.find({
-      courseCode: courseCode.toUpperCase(),
-      isActive: true,
-      publishDate: { $lte: new Date() }
-    })
-    .sort({ createdAt: -1 })
-    .limit(limit * 1)
-    .skip((page - 1) * limit);
+    const materials = await Material.find({
+      courseCode: courseCode.toUpperCase(),
+      isActive: true,
+      publishDate: { $lte: new Date() }
+    })
+    .sort({ createdAt: -1 })
+    .limit(limit * 1)
+    .skip((page - 1) * limit);
+
+    const totalMaterials = await Material.countDocuments({
+      courseCode: courseCode.toUpperCase(),
+      isActive: true,
+      publishDate: { $lte: new Date() }
+    });
+
+    res.json({
+      success: true,
+      data: {
+        materials,
+        pagination: {
+          currentPage: page,
+          totalPages: Math.ceil(totalMaterials / limit),
+          totalMaterials,
+          hasMore: page * limit < totalMaterials
+        }
+      }
+    });
+
+  } catch (error) {
+    console.error('Get materials error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch materials'
+    });
+  }
+});
+
+// Students may only reach materials of courses they are enrolled in
+const ensureMaterialAccess = async (req, res, material) => {
+  if (req.user.role !== 'student') return true;
+
+  const student = await User.findOne({ studentId: req.user.studentId }).select('enrolledCourses').lean();
+  if (!student || !student.enrolledCourses.includes(material.courseCode)) {
+    res.status(403).json({
+      success: false,
+      error: 'Access denied. You are not enrolled in this course.'
+    });
+    return false;
+  }
+  return true;
+};
+
+// Stream Video Material (HLS master playlist, rendition playlists and segments)
+app.get('/api/materials/:id/stream/:revision/*', authenticateToken, async (req, res) => {
+  try {
+    const file = req.params[0];
+    if (!/^([\w-]+\/)?[\w-]+\.(m3u8|ts)$/.test(file) || !/^\d+$/.test(req.params.revision)) {
+      return res.status(404).json({
+        success: false,
+        error: 'Stream file not found'
+      });
+    }
+
+    const material = await Material.findById(req.params.id).select('courseCode isActive streaming').lean();
+    if (!material || !material.isActive || material.streaming?.status !== 'ready') {
+      return res.status(404).json({
+        success: false,
+        error: 'Stream not available'
+      });
+    }
+
+    if (!(await ensureMaterialAccess(req, res, material))) return;
+
+    const filePath = path.join(hlsDir, String(material._id), `r${req.params.revision}`, file);
+    if (!fs.existsSync(filePath)) {
+      return res.status(404).json({
+        success: false,
+        error: 'Stream file not found'
+      });
+    }
+
+    // Revision directories are write-once, so segments and playlists never change under a URL
+    res.set('Cache-Control', 'private, max-age=31536000, immutable');
+    res.sendFile(filePath, {
+      headers: {
+        'Content-Type': file.endsWith('.m3u8') ? 'application/vnd.apple.mpegurl' : 'video/mp2t'
+      }
+    });
+
+  } catch (error) {
+    console.error('Stream material error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to stream material'
+    });
+  }
+});
+
+// Get Material Manifest (lets clients fetch only the chunks they do not already hold)
+app.get('/api/materials/:id/manifest', authenticateToken, async (req, res) => {
+  try {
+    const material = await Material.findById(req.params.id).select('+manifest');
+
+    if (!material || !material.isActive) {
+      return res.status(404).json({
+        success: false,
+        error: 'Material not found'
+      });
+    }
+
+    if (!(await ensureMaterialAccess(req, res, material))) return;
+
+    res.json({
+      success: true,
+      data: {
+        _id: material._id,
+        revision: material.revision,
+        fileName: material.fileName,
+        fileSize: material.fileSize,
+        fileHash: material.fileHash,
+        chunks: material.manifest
+      }
+    });
+
+  } catch (error) {
+    console.error('Get material manifest error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch material manifest'
+    });
+  }
+});
+
+// Get Material Chunk (content-addressed, so it never changes and can be cached forever)
+app.get('/api/materials/chunks/:hash', authenticateToken, async (req, res) => {
+  try {
+    const hash = req.params.hash.toLowerCase();
+    if (!/^[a-f0-9]{64}$/.test(hash) || !(await hasChunk(hash))) {
+      return res.status(404).json({
+        success: false,
+        error: 'Chunk not found'
+      });
+    }
+
+    res.set('Cache-Control', 'private, max-age=31536000, immutable');
+    res.set('ETag', `"${hash}"`);
+    res.sendFile(chunkPath(hash), { headers: { 'Content-Type': 'application/octet-stream' } });
 
-    const totalMaterials = await Material.countDocuments({
-      courseCode: courseCode.toUpperCase(),
-      isActive: true,
-      publishDate: { $lte: new Date() }
+  } catch (error) {
+    console.error('Get material chunk error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch chunk'
     });
+  }
+});
 
-    res.json({
-      success: true,
-      data: {
-        materials,
-        pagination: {
-          currentPage: page,
-          totalPages: Math.ceil(totalMaterials / limit),
-          totalMaterials,
-          hasMore: page * limit < totalMaterials
-        }
-      }
+// Image variants
+// Profile images and image materials are served as JPEG variants at a few fixed sizes, generated
+// once with ffmpeg into uploads/variants. Variant files are keyed by the source's content hash, so
+// URLs carrying that hash as their version never change and are cached as immutable.
+const IMAGE_VARIANT_SIZES = [48, 96, 192, 384, 768];
+const imageVariantsDir = path.join(uploadsDir, 'variants');
+const pendingImageVariants = new Map();
+
+const snapImageSize = (requested) => {
+  const size = parseInt(requested, 10) || IMAGE_VARIANT_SIZES[1];
+  return IMAGE_VARIANT_SIZES.find(candidate => candidate >= size) || IMAGE_VARIANT_SIZES[IMAGE_VARIANT_SIZES.length - 1];
+};
+
+// 'cover' crops to a size×size square (avatars); 'inside' fits within it without upscaling (previews)
+const getImageVariant = (key, size, fit, loadSource) => {
+  const variantPath = path.join(imageVariantsDir, `${key}-${size}-${fit}.jpg`);
+  if (fs.existsSync(variantPath)) return Promise.resolve(variantPath);
+  if (pendingImageVariants.has(variantPath)) return pendingImageVariants.get(variantPath);
+
+  const task = (async () => {
+    const suffix = crypto.randomBytes(6).toString('hex');
+    const sourcePath = `${variantPath}.${suffix}.src`;
+    const tempPath = `${variantPath}.${suffix}.tmp.jpg`;
+    const scale = fit === 'cover'
+      ? `scale=${size}:${size}:force_original_aspect_ratio=increase,crop=${size}:${size}`
+      : `scale=w=min(iw\\,${size}):h=min(ih\\,${size}):force_original_aspect_ratio=decrease`;
+    try {
+      await fs.promises.mkdir(imageVariantsDir, { recursive: true });
+      await fs.promises.writeFile(sourcePath, await loadSource());
+      await execFileAsync(FFMPEG_PATH, ['-y', '-loglevel', 'error', '-i', sourcePath, '-vf', scale, '-frames:v', '1', '-q:v', '4', tempPath]);
+      await fs.promises.rename(tempPath, variantPath);
+      return variantPath;
+    } finally {
+      await fs.promises.unlink(sourcePath).catch(() => {});
+      await fs.promises.unlink(tempPath).catch(() => {});
+    }
+  })().finally(() => pendingImageVariants.delete(variantPath));
+
+  pendingImageVariants.set(variantPath, task);
+  return task;
+};
+
+// Send a variant, or the original image when it cannot be generated (e.g. ffmpeg missing)
+const sendImageVariant = async (req, res, { key, version, fit, loadSource, mimeType }) => {
+  const size = snapImageSize(req.query.size);
+  const requestedFit = req.query.fit === 'cover' || req.query.fit === 'inside' ? req.query.fit : fit;
+  const isCurrent = req.params.version === version;
+
+  try {
+    const variantPath = await getImageVariant(key, size, requestedFit, loadSource);
+    res.set('Cache-Control', isCurrent ? 'private, max-age=31536000, immutable' : 'private, max-age=300');
+    res.sendFile(variantPath, { headers: { 'Content-Type': 'image/jpeg' } });
+  } catch (error) {
+    console.error('Image variant error:', error.message);
+    res.set('Cache-Control', 'private, max-age=300');
+    res.type(mimeType || 'image/jpeg').send(await loadSource());
+  }
+};
+
+// Get Student Profile Image (admins, or the student themself)
+app.get('/api/images/students/:studentId/:version', authenticateToken, async (req, res) => {
+  try {
+    if (req.user.role !== 'admin' && req.user.studentId !== req.params.studentId) {
+      return res.status(403).json({
+        success: false,
+        error: 'Access denied'
+      });
+    }
+
+    const student = await User.findOne({ studentId: req.params.studentId, role: 'student' })
+      .select('profileImage profileImageHash')
+      .lean();
+    const image = student && decodeImagePayload(student.profileImage);
+    if (!image) {
+      return res.status(404).json({
+        success: false,
+        error: 'Profile image not found'
+      });
+    }
+
+    const { mimeType, buffer } = image;
+    const version = student.profileImageHash || crypto.createHash('sha1').update(student.profileImage).digest('hex').slice(0, 16);
+    await sendImageVariant(req, res, {
+      key: `profile-${version}`,
+      version,
+      fit: 'cover',
+      mimeType,
+      loadSource: async () => buffer
     });
 
   } catch (error) {
-    console.error('Get materials error:', error);
+    console.error('Get profile image error:', error);
     res.status(500).json({
       success: false,
-      error: 'Failed to fetch materials'
+      error: 'Failed to fetch profile image'
+    });
+  }
+});
+
+// Get Image Material Preview
+app.get('/api/images/materials/:id/:version', authenticateToken, async (req, res) => {
+  try {
+    const material = await Material.findById(req.params.id).select('+manifest');
+    if (!material || !material.isActive || material.materialType !== 'image' || !hasMaterialFile(material)) {
+      return res.status(404).json({
+        success: false,
+        error: 'Image not found'
+      });
+    }
+
+    if (!(await ensureMaterialAccess(req, res, material))) return;
+
+    const version = material.fileHash || String(material.updatedAt.getTime());
+    await sendImageVariant(req, res, {
+      key: `material-${version}`,
+      version,
+      fit: 'inside',
+      loadSource: () => readMaterialFile(material)
+    });
+
+  } catch (error) {
+    console.error('Get material image error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch image'
     });
   }
 });
@@ -1149,7 +4151,7 @@ app.get('/api/materials/:courseCode', authenticateToken, async (req, res) => {
 // Download Material
 app.get('/api/materials/download/:id', authenticateToken, async (req, res) => {
   try {
-    const material = await Material.findById(req.params.id);
+    const material = await Material.findById(req.params.id).select('+manifest');
     
     if (!material || !material.isActive) {
       return res.status(404).json({
@@ -1159,21 +4161,51 @@ app.get('/api/materials/download/:id', authenticateToken, async (req, res) => {
     }
 
     // Check if student is enrolled in the course
-    if (req.user.role === 'student') {
-      const student = await User.findOne({ studentId: req.user.studentId });
-      if (!student.enrolledCourses.includes(material.courseCode)) {
-        return res.status(403).json({
-          success: false,
-          error: 'Access denied. You are not enrolled in this course.'
-        });
-      }
+    if (!(await ensureMaterialAccess(req, res, material))) return;
+
+    // Count new downloads only: not revalidations, resumed ranges or offline prefetches
+    const rangeHeader = req.get('Range');
+    const isNewDownload = !req.get('If-None-Match') && req.query.prefetch !== '1' &&
+      (!rangeHeader || /^bytes=0-/.test(rangeHeader));
+    if (isNewDownload) {
+      await Material.updateOne({ _id: material._id }, { $inc: { downloadCount: 1 } });
     }
 
-    // Increment download count
-    material.downloadCount += 1;
-    await material.save();
+    if (material.manifest.length > 0) {
+      for (const { hash, size } of material.manifest) {
+        if (!(await hasChunk(hash, size))) {
+          return res.status(404).json({
+            success: false,
+            error: 'File not found'
+          });
+        }
+      }
+
+      const etag = `"${material.fileHash}"`;
+      res.set('ETag', etag);
+      res.set('Accept-Ranges', 'bytes');
+      if (req.get('If-None-Match') === etag) {
+        return res.status(304).end();
+      }
 
-    if (material.filePath && fs.existsSync(material.filePath)) {
+      res.attachment(material.fileName);
+      const ifRange = req.get('If-Range');
+      const ranges = rangeHeader && (!ifRange || ifRange === etag) ? req.range(material.fileSize) : undefined;
+      if (ranges === -1) {
+        res.set('Content-Range', `bytes */${material.fileSize}`);
+        return res.status(416).end();
+      }
+      if (Array.isArray(ranges) && ranges.type === 'bytes' && ranges.length === 1) {
+        const { start, end } = ranges[0];
+        res.status(206);
+        res.set('Content-Range', `bytes ${start}-${end}/${material.fileSize}`);
+        res.set('Content-Length', String(end - start + 1));
+        await pipeline(Readable.from(readManifestChunks(material.manifest, start, end)), res);
+      } else {
+        res.set('Content-Length', String(material.fileSize));
+        await pipeline(Readable.from(readManifestChunks(material.manifest)), res);
+      }
+    } else if (material.filePath && fs.existsSync(material.filePath)) {
       res.download(material.filePath, material.fileName);
     } else {
       res.status(404).json({
@@ -1183,6 +4215,14 @@ app.get('/api/materials/download/:id', authenticateToken, async (req, res) => {
     }
 
   } catch (error) {
+    // Once the body has started streaming the status is committed; an aborted
+    // or failed chunk read can only end the connection
+    if (res.headersSent) {
+      if (error.code !== 'ERR_STREAM_PREMATURE_CLOSE') {
+        console.error('Download material stream error:', error);
+      }
+      return res.destroy();
+    }
     console.error('Download material error:', error);
     res.status(500).json({
       success: false,
@@ -1192,23 +4232,12 @@ app.get('/api/materials/download/:id', authenticateToken, async (req, res) => {
 });
 
 // Enhanced Attendance Marking
-app.post('/api/student/attendance', authenticateToken, requireStudent, async (req, res) => {
+app.post('/api/student/attendance', authenticateToken, requireStudent, validateBody('attendance'), async (req, res) => {
   try {
     const { courseCode, faceData, location, notes } = req.body;
     const studentId = req.user.studentId;
 
-    if (!courseCode) {
-      return res.status(400).json({
-        success: false,
-        error: 'Course code is required'
-      });
-    }
-
-    const student = await User.findOne({ 
-      studentId: studentId, 
-      role: 'student',
-      isActive: true 
-    });
+    const student = await findActiveStudent(studentId);
 
     if (!student) {
       return res.status(404).json({
@@ -1224,12 +4253,7 @@ app.post('/api/student/attendance', authenticateToken, requireStudent, async (re
       });
     }
 
-    const course = await Course.findOne({ 
-      courseCode: courseCode.toUpperCase(),
-      isActive: true 
-    });
-
-    if (!course) {
+    if (!(await activeCourseExists(courseCode.toUpperCase()))) {
       return res.status(404).json({
         success: false,
         error: 'Course not found'
@@ -1237,13 +4261,7 @@ app.post('/api/student/attendance', authenticateToken, requireStudent, async (re
     }
 
     const today = new Date().toISOString().split('T')[0];
-    const existingAttendance = await Attendance.findOne({
-      studentId: studentId,
-      courseCode: courseCode.toUpperCase(),
-      date: today
-    });
-
-    if (existingAttendance) {
+    if (await attendanceExists(studentId, courseCode.toUpperCase(), today)) {
       return res.status(400).json({
         success: false,
         error: 'Attendance already marked for today in this course'
@@ -1292,7 +4310,7 @@ app.post('/api/student/attendance', authenticateToken, requireStudent, async (re
       }
     }
 
-    const attendance = new Attendance({
+    const savedAttendance = await insertAttendance({
       studentId: studentId,
       studentName: student.studentName,
       courseCode: courseCode.toUpperCase(),
@@ -1307,8 +4325,7 @@ app.post('/api/student/attendance', authenticateToken, requireStudent, async (re
       isLate: isLate,
       lateMinutes: lateMinutes
     });
-
-    const savedAttendance = await attendance.save();
+    await onAttendanceRecorded(savedAttendance);
 
     if (isLate) {
       await createNotification(
@@ -1352,7 +4369,9 @@ app.post('/api/student/attendance', authenticateToken, requireStudent, async (re
 });
 
 // Enhanced Student Dashboard
-app.get('/api/student/dashboard', authenticateToken, requireStudent, async (req, res) => {
+app.get('/api/student/dashboard', authenticateToken, requireStudent, conditionalGet(req => [
+  userScope(req), `attendance:${req.user.studentId}`, notificationScope(req), 'materials', 'courses', 'streaks', dayScope()
+]), async (req, res) => {
   try {
     const studentId = req.user.studentId;
     
@@ -1423,6 +4442,12 @@ app.get('/api/student/dashboard', authenticateToken, requireStudent, async (req,
     .sort({ createdAt: -1 })
     .limit(10);
 
+    // Get attendance streaks
+    const streaks = await StudentSummary.find({ studentId: studentId })
+      .select('courseCode currentStreak bestStreak lastSessionDate lastAttendedDate -_id')
+      .sort({ courseCode: 1 })
+      .lean();
+
     res.json({
       success: true,
       data: {
@@ -1446,6 +4471,7 @@ app.get('/api/student/dashboard', authenticateToken, requireStudent, async (req,
         },
         recentAttendance,
         courseStats,
+        streaks,
         upcomingMaterials,
         notifications
       }
@@ -1460,8 +4486,58 @@ app.get('/api/student/dashboard', authenticateToken, requireStudent, async (req,
   }
 });
 
+// Incremental attendance history for the app's local replica. Records are append-only, so the
+// cursor is the last ObjectId returned; it never moves past the settle window, which re-sends
+// (rather than skips) records whose inserts were still in flight when the page was read
+const ATTENDANCE_SYNC_PAGE_SIZE = 500;
+const ATTENDANCE_SYNC_SETTLE_SECONDS = 60;
+
+app.get('/api/student/attendance/sync', authenticateToken, requireStudent, async (req, res) => {
+  try {
+    const { after = '' } = req.query;
+    const limit = Math.min(Math.max(parseInt(req.query.limit, 10) || ATTENDANCE_SYNC_PAGE_SIZE, 1), ATTENDANCE_SYNC_PAGE_SIZE);
+
+    if (after && !mongoose.Types.ObjectId.isValid(after)) {
+      return res.status(400).json({
+        success: false,
+        error: 'Invalid sync cursor'
+      });
+    }
+
+    const filter = { studentId: req.user.studentId };
+    if (after) {
+      filter._id = { $gt: new mongoose.Types.ObjectId(after) };
+    }
+
+    const records = await Attendance.find(filter)
+      .select('courseCode date status timestamp isLate lateMinutes method confidenceScore notes')
+      .sort({ _id: 1 })
+      .limit(limit)
+      .lean();
+
+    const settled = mongoose.Types.ObjectId.createFromTime(Math.floor(Date.now() / 1000) - ATTENDANCE_SYNC_SETTLE_SECONDS).toHexString();
+    const lastId = records.length > 0 ? records[records.length - 1]._id.toHexString() : after;
+    const cursor = lastId < settled ? lastId : [after, settled].sort().pop();
+
+    res.json({
+      success: true,
+      data: {
+        records,
+        cursor,
+        hasMore: records.length === limit
+      }
+    });
+  } catch (error) {
+    console.error('Attendance sync error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to sync attendance'
+    });
+  }
+});
+
 // Get Student Materials
-app.get('/api/student/materials', authenticateToken, requireStudent, async (req, res) => {
+app.get('/api/student/materials', authenticateToken, requireStudent, conditionalGet(req => [userScope(req), 'materials']), async (req, res) => {
   try {
     const studentId = req.user.studentId;
     const { courseCode, page = 1, limit = 20 } = req.query;
@@ -1514,7 +4590,7 @@ app.get('/api/student/materials', authenticateToken, requireStudent, async (req,
 });
 
 // Get Notifications
-app.get('/api/notifications', authenticateToken, async (req, res) => {
+app.get('/api/notifications', authenticateToken, conditionalGet(req => [notificationScope(req)]), async (req, res) => {
   try {
     const userId = req.user.role === 'admin' ? req.user.uniqueId : req.user.studentId;
     const { page = 1, limit = 20, unreadOnly = false } = req.query;
@@ -1572,6 +4648,7 @@ app.put('/api/notifications/:id/read', authenticateToken, async (req, res) => {
         error: 'Notification not found'
       });
     }
+    bumpVersion(`notifications:${userId}`);
 
     res.json({
       success: true,
@@ -1588,16 +4665,49 @@ app.put('/api/notifications/:id/read', authenticateToken, async (req, res) => {
   }
 });
 
+// Optional startDate/endDate query bounds; an unparseable value is reported instead of thrown
+const parseDateRange = ({ startDate, endDate }) => {
+  const range = {};
+  for (const [key, value] of [['start', startDate], ['end', endDate]]) {
+    if (value === undefined || value === '') continue;
+    const date = new Date(String(value));
+    if (Number.isNaN(date.getTime())) {
+      return { error: `${key}Date must be a valid date (e.g. 2024-09-01)` };
+    }
+    range[key] = date;
+  }
+  if (range.start && range.end && range.start > range.end) {
+    return { error: 'startDate must not be after endDate' };
+  }
+  return range;
+};
+
 // Enhanced Admin Analytics
-app.get('/api/admin/analytics', authenticateToken, requireAdmin, async (req, res) => {
+app.get('/api/admin/analytics', authenticateToken, requireAdmin, conditionalGet(() => [
+  'students', 'courses', 'materials', 'attendance', dayScope()
+]), async (req, res) => {
   try {
-    const { startDate, endDate, courseCode } = req.query;
+    const { courseCode } = req.query;
+    const range = parseDateRange(req.query);
+    if (range.error) {
+      return res.status(400).json({
+        success: false,
+        error: range.error
+      });
+    }
+    // LTTB keeps the first and last day plus one per bucket, so fewer than 3 points cannot decimate
+    if (req.query.points !== undefined && !(parseInt(req.query.points, 10) >= 3)) {
+      return res.status(400).json({
+        success: false,
+        error: 'points must be a number of at least 3'
+      });
+    }
 
     let dateFilter = {};
-    if (startDate || endDate) {
+    if (range.start || range.end) {
       dateFilter.timestamp = {};
-      if (startDate) dateFilter.timestamp.$gte = new Date(startDate);
-      if (endDate) dateFilter.timestamp.$lte = new Date(endDate);
+      if (range.start) dateFilter.timestamp.$gte = range.start;
+      if (range.end) dateFilter.timestamp.$lte = range.end;
     }
 
     let courseFilter = {};
@@ -1711,70 +4821,291 @@ app.get('/api/admin/analytics', authenticateToken, requireAdmin, async (req, res
       { $limit: 10 }
     ]);
 
-    // Daily trend (last 30 days)
-    const thirtyDaysAgo = new Date();
-    thirtyDaysAgo.setDate(thirtyDaysAgo.getDate() - 30);
+    // Daily trend (last 30 days unless trendDays is given), decimated to `points` when requested
+    const trendDays = Math.min(Math.max(parseInt(req.query.trendDays, 10) || 30, 1), 730);
+    const trendStart = new Date();
+    trendStart.setDate(trendStart.getDate() - trendDays);
+
+    const dailyTrendSeries = await buildDailyTurnout(trendStart, courseFilter);
+    const dailyTrend = decimateSeries(dailyTrendSeries, req.query, day => Date.parse(day._id), day => day.attendanceRate);
+
+    res.json({
+      success: true,
+      data: {
+        overview: {
+          totalStudents,
+          totalCourses,
+          totalMaterials,
+          totalAttendanceRecords,
+          presentCount,
+          lateCount,
+          absentCount,
+          overallAttendanceRate: totalAttendanceRecords > 0 
+            ? (((presentCount + lateCount) / totalAttendanceRecords) * 100).toFixed(1) 
+            : '0'
+        },
+        coursePerformance,
+        topStudents,
+        dailyTrend,
+        dailyTrendInfo: {
+          days: trendDays,
+          sourcePoints: dailyTrendSeries.length,
+          points: dailyTrend.length,
+          decimation: dailyTrend.length < dailyTrendSeries.length ? (req.query.decimation === 'minmax' ? 'minmax' : 'lttb') : 'none'
+        },
+        attendanceBreakdown: {
+          present: presentCount,
+          late: lateCount,
+          absent: absentCount
+        }
+      }
+    });
+
+  } catch (error) {
+    console.error('Get analytics error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch analytics data'
+    });
+  }
+});
+
+// Attendance Heatmap (weekday × hour turnout, served from the precomputed cube)
+app.get('/api/admin/analytics/heatmap', authenticateToken, requireAdmin, conditionalGet(() => ['attendance']), async (req, res) => {
+  try {
+    const { courseCode } = req.query;
+
+    const filter = courseCode ? { courseCode: courseCode.toUpperCase() } : {};
+    const rows = await AttendanceHeatmap.find(filter).select('-_id -__v').lean();
+
+    // Fold courses together into at most 7 × 24 cells
+    const cellMap = new Map();
+    rows.forEach(row => {
+      const key = row.weekday * 24 + row.hour;
+      if (!cellMap.has(key)) {
+        cellMap.set(key, { weekday: row.weekday, hour: row.hour, present: 0, late: 0, absent: 0, excused: 0 });
+      }
+      const cell = cellMap.get(key);
+      cell.present += row.present || 0;
+      cell.late += row.late || 0;
+      cell.absent += row.absent || 0;
+      cell.excused += row.excused || 0;
+    });
+
+    const cells = [...cellMap.values()]
+      .map(cell => {
+        const total = cell.present + cell.late + cell.absent + cell.excused;
+        return {
+          ...cell,
+          total,
+          attendanceRate: total > 0 ? ((cell.present + cell.late) / total) * 100 : 0
+        };
+      })
+      .filter(cell => cell.total > 0)
+      .sort((a, b) => a.weekday - b.weekday || a.hour - b.hour);
+
+    const worstSlot = cells.reduce(
+      (worst, cell) => (!worst || cell.attendanceRate < worst.attendanceRate ? cell : worst),
+      null
+    );
+
+    res.json({
+      success: true,
+      data: {
+        courseCode: courseCode ? courseCode.toUpperCase() : null,
+        cells,
+        worstSlot
+      }
+    });
+
+  } catch (error) {
+    console.error('Get heatmap error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch attendance heatmap'
+    });
+  }
+});
+// Lateness Percentiles (merges the per-course, per-day t-digests in range)
+app.get('/api/admin/analytics/lateness', authenticateToken, requireAdmin, conditionalGet(() => ['attendance']), async (req, res) => {
+  try {
+    const { courseCode } = req.query;
+    const range = parseDateRange(req.query);
+    if (range.error) {
+      return res.status(400).json({
+        success: false,
+        error: range.error
+      });
+    }
+
+    const filter = {};
+    if (courseCode) filter.courseCode = courseCode.toUpperCase();
+    if (range.start || range.end) {
+      filter.date = {};
+      if (range.start) filter.date.$gte = range.start.toISOString().split('T')[0];
+      if (range.end) filter.date.$lte = range.end.toISOString().split('T')[0];
+    }
+
+    const digests = await LatenessDigest.find(filter).select('courseCode centroids count sum min max').lean();
+
+    const summarize = (docs) => {
+      const digest = new TDigest(LATENESS_DIGEST_COMPRESSION);
+      let sum = 0;
+      docs.forEach(doc => {
+        digest.merge(doc.centroids, doc.min, doc.max);
+        sum += doc.sum || 0;
+      });
+      const round = (value) => (value === null ? null : Math.round(value * 10) / 10);
+      return {
+        count: digest.count,
+        mean: digest.count > 0 ? round(sum / digest.count) : null,
+        min: digest.count > 0 ? digest.min : null,
+        max: digest.count > 0 ? digest.max : null,
+        p50: round(digest.quantile(0.5)),
+        p90: round(digest.quantile(0.9)),
+        p99: round(digest.quantile(0.99))
+      };
+    };
+
+    const docsByCourse = {};
+    digests.forEach(doc => {
+      (docsByCourse[doc.courseCode] = docsByCourse[doc.courseCode] || []).push(doc);
+    });
+
+    res.json({
+      success: true,
+      data: {
+        overall: summarize(digests),
+        byCourse: Object.keys(docsByCourse).sort().map(code => ({
+          courseCode: code,
+          ...summarize(docsByCourse[code])
+        }))
+      }
+    });
+
+  } catch (error) {
+    console.error('Get lateness percentiles error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch lateness percentiles'
+    });
+  }
+});
+// Live session snapshot for instructors
+app.get('/api/admin/live/:courseCode', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const session = await openLiveSession(req.params.courseCode.toUpperCase());
+    if (!session) {
+      return res.status(404).json({
+        success: false,
+        error: 'Course not found'
+      });
+    }
+
+    res.type('application/json').send(liveSnapshotJson(session));
+
+  } catch (error) {
+    console.error('Get live session error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch live session'
+    });
+  }
+});
+
+// Live session stream (long poll: answers as soon as the session moves past `since`)
+app.get('/api/admin/live/:courseCode/stream', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const since = parseInt(req.query.since, 10) || 0;
+    const session = await openLiveSession(req.params.courseCode.toUpperCase());
+    if (!session) {
+      return res.status(404).json({
+        success: false,
+        error: 'Course not found'
+      });
+    }
+
+    if (session.version !== since || session.closed) {
+      return res.type('application/json').send(liveChangesJson(session, since));
+    }
+
+    let timer = null;
+    const waiter = (current) => {
+      clearTimeout(timer);
+      res.type('application/json').send(liveChangesJson(current, since));
+    };
+    timer = setTimeout(() => {
+      session.waiters.delete(waiter);
+      res.type('application/json').send(liveChangesJson(session, since));
+    }, LIVE_STREAM_TIMEOUT_MS);
+    session.waiters.add(waiter);
+    req.on('close', () => {
+      clearTimeout(timer);
+      session.waiters.delete(waiter);
+    });
+
+  } catch (error) {
+    console.error('Live session stream error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to stream live session'
+    });
+  }
+});
+
+// Close out a course session (resets the streak of enrolled students who did not attend)
+app.post('/api/admin/courses/:courseCode/sessions/:date/close', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const courseCode = req.params.courseCode.toUpperCase();
+    const { date } = req.params;
 
-    const dailyTrend = await Attendance.aggregate([
-      { 
-        $match: { 
-          timestamp: { $gte: thirtyDaysAgo },
-          ...courseFilter
-        }
-      },
-      {
-        $group: {
-          _id: '$date',
-          totalSessions: { $sum: 1 },
-          presentSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'present'] }, 1, 0] }
-          },
-          lateSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'late'] }, 1, 0] }
-          }
-        }
-      },
-      { $sort: { _id: 1 } }
-    ]);
+    if (!/^\d{4}-\d{2}-\d{2}$/.test(date)) {
+      return res.status(400).json({
+        success: false,
+        error: 'Session date must be in YYYY-MM-DD format'
+      });
+    }
+
+    const result = await closeOutCourseSession(courseCode, date);
 
     res.json({
       success: true,
-      data: {
-        overview: {
-          totalStudents,
-          totalCourses,
-          totalMaterials,
-          totalAttendanceRecords,
-          presentCount,
-          lateCount,
-          absentCount,
-          overallAttendanceRate: totalAttendanceRecords > 0 
-            ? (((presentCount + lateCount) / totalAttendanceRecords) * 100).toFixed(1) 
-            : '0'
-        },
-        coursePerformance,
-        topStudents,
-        dailyTrend,
-        attendanceBreakdown: {
-          present: presentCount,
-          late: lateCount,
-          absent: absentCount
-        }
-      }
+      message: `Session ${date} closed for ${courseCode}`,
+      data: result
     });
 
   } catch (error) {
-    console.error('Get analytics error:', error);
+    console.error('Close session error:', error);
     res.status(500).json({
       success: false,
-      error: 'Failed to fetch analytics data'
+      error: 'Failed to close session'
+    });
+  }
+});
+
+// Recompute all attendance streaks from history
+app.post('/api/admin/streaks/backfill', authenticateToken, requireAdmin, async (req, res) => {
+  try {
+    const results = await backfillAttendanceStreaks();
+
+    res.json({
+      success: true,
+      message: `Backfilled streaks for ${results.length} courses`,
+      data: results
+    });
+
+  } catch (error) {
+    console.error('Backfill streaks error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to backfill streaks'
     });
   }
 });
 // Add these routes to your server.js file
 
 // Get all courses (for admin)
-app.get('/api/admin/courses', authenticateToken, requireAdmin, async (req, res) => {
+app.get('/api/admin/courses', authenticateToken, requireAdmin, conditionalGet(() => ['courses']), async (req, res) => {
   try {
     const courses = await Course.find({ isActive: true }).sort({ courseCode: 1 });
     
@@ -1794,7 +5125,7 @@ app.get('/api/admin/courses', authenticateToken, requireAdmin, async (req, res)
 });
 
 // Create new course
-app.post('/api/admin/courses', authenticateToken, requireAdmin, async (req, res) => {
+app.post('/api/admin/courses', authenticateToken, requireAdmin, validateBody('course'), async (req, res) => {
   try {
     const { 
       courseCode, 
@@ -1809,13 +5140,6 @@ app.post('/api/admin/courses', authenticateToken, requireAdmin, async (req, res)
       academicYear 
     } = req.body;
 
-    if (!courseCode || !courseName) {
-      return res.status(400).json({
-        success: false,
-        error: 'Course code and name are required'
-      });
-    }
-
     // Check if course already exists
     const existingCourse = await Course.findOne({ 
       courseCode: courseCode.toUpperCase() 
@@ -1843,6 +5167,7 @@ app.post('/api/admin/courses', authenticateToken, requireAdmin, async (req, res)
     });
 
     const savedCourse = await course.save();
+    bumpVersion('courses');
 
     res.status(201).json({
       success: true,
@@ -1868,7 +5193,7 @@ app.post('/api/admin/courses', authenticateToken, requireAdmin, async (req, res)
 });
 
 // Get all students (for admin)
-app.get('/api/admin/students', authenticateToken, requireAdmin, async (req, res) => {
+app.get('/api/admin/students', authenticateToken, requireAdmin, conditionalGet(() => ['students']), async (req, res) => {
   try {
     const { page = 1, limit = 50, search, courseCode } = req.query;
 
@@ -1889,7 +5214,7 @@ app.get('/api/admin/students', authenticateToken, requireAdmin, async (req, res)
     }
 
     const students = await User.find(filter)
-      .select('-faceEncodings -password')
+      .select('-faceEncodings -password -profileImage')
       .sort({ studentName: 1 })
       .limit(limit * 1)
       .skip((page - 1) * limit);
@@ -1921,265 +5246,87 @@ app.delete('/api/admin/students/:id', authenticateToken, requireAdmin, async (re
   try {
     const studentId = req.params.id;
 
-    const student = await User.findById(studentId);
-    if (!student || student.role !== 'student') {
-      return res.status(404).json({
-        success: false,
-        error: 'Student not found'
-      });
-    }
-
-    // Remove student from all courses
-    if (student.enrolledCourses && student.enrolledCourses.length > 0) {
-      await Course.updateMany(
-        { courseCode: { $in: student.enrolledCourses } },
-        { $pull: { enrolledStudents: student.studentId } }
-      );
-    }
-
-    // Delete all attendance records
-    await Attendance.deleteMany({ studentId: student.studentId });
-
-    // Delete the student
-    await User.findByIdAndDelete(studentId);
-
-    res.json({
-      success: true,
-      message: 'Student deleted successfully'
-    });
-
-  } catch (error) {
-    console.error('Delete student error:', error);
-    res.status(500).json({
-      success: false,
-      error: 'Failed to delete student'
-    });
-  }
-});
-
-// Get student courses (for student dashboard)
-app.get('/api/student/courses', authenticateToken, requireStudent, async (req, res) => {
-  try {
-    const studentId = req.user.studentId;
-    
-    const student = await User.findOne({ 
-      studentId: studentId, 
-      role: 'student',
-      isActive: true 
-    });
-
-    if (!student) {
-      return res.status(404).json({
-        success: false,
-        error: 'Student not found'
-      });
-    }
-
-    const courses = await Course.find({
-      courseCode: { $in: student.enrolledCourses },
-      isActive: true
-    }).select('courseCode courseName instructor schedule');
-
-    res.json({
-      success: true,
-      data: courses
-    });
-
-  } catch (error) {
-    console.error('Get student courses error:', error);
-    res.status(500).json({
-      success: false,
-      error: 'Failed to fetch courses'
-    });
-  }
-});
-
-// Update existing admin analytics route to handle course filtering
-app.get('/api/admin/analytics', authenticateToken, requireAdmin, async (req, res) => {
-  try {
-    const { startDate, endDate, courseCode } = req.query;
-
-    let dateFilter = {};
-    if (startDate || endDate) {
-      dateFilter.timestamp = {};
-      if (startDate) dateFilter.timestamp.$gte = new Date(startDate);
-      if (endDate) dateFilter.timestamp.$lte = new Date(endDate);
-    }
-
-    let courseFilter = {};
-    if (courseCode) {
-      courseFilter.courseCode = courseCode.toUpperCase();
-    }
-
-    const attendanceFilter = { ...dateFilter, ...courseFilter };
-
-    // Basic counts
-    const totalStudents = await User.countDocuments({ role: 'student', isActive: true });
-    const totalCourses = await Course.countDocuments({ isActive: true });
-    const totalMaterials = await Material.countDocuments({ isActive: true });
-    const totalAttendanceRecords = await Attendance.countDocuments(attendanceFilter);
-
-    // Attendance statistics
-    const attendanceStats = await Attendance.aggregate([
-      { $match: attendanceFilter },
-      {
-        $group: {
-          _id: '$status',
-          count: { $sum: 1 }
-        }
-      }
-    ]);
-
-    let presentCount = 0;
-    let lateCount = 0;
-    let absentCount = 0;
-    
-    attendanceStats.forEach(stat => {
-      if (stat._id === 'present') presentCount = stat.count;
-      if (stat._id === 'late') lateCount = stat.count;
-      if (stat._id === 'absent') absentCount = stat.count;
-    });
-
-    // Course-wise performance
-    const coursePerformance = await Attendance.aggregate([
-      { $match: attendanceFilter },
-      {
-        $group: {
-          _id: '$courseCode',
-          totalSessions: { $sum: 1 },
-          presentSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'present'] }, 1, 0] }
-          },
-          lateSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'late'] }, 1, 0] }
-          },
-          uniqueStudents: { $addToSet: '$studentId' }
-        }
-      },
-      {
-        $project: {
-          courseCode: '$_id',
-          totalSessions: 1,
-          presentSessions: 1,
-          lateSessions: 1,
-          studentCount: { $size: '$uniqueStudents' },
-          attendanceRate: {
-            $multiply: [
-              { 
-                $divide: [
-                  { $add: ['$presentSessions', '$lateSessions'] }, 
-                  '$totalSessions'
-                ] 
-              },
-              100
-            ]
-          }
-        }
-      },
-      { $sort: { courseCode: 1 } }
-    ]);
-
-    // Top performing students
-    const topStudents = await Attendance.aggregate([
-      { $match: attendanceFilter },
-      {
-        $group: {
-          _id: '$studentId',
-          studentName: { $first: '$studentName' },
-          totalSessions: { $sum: 1 },
-          presentSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'present'] }, 1, 0] }
-          },
-          lateSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'late'] }, 1, 0] }
-          }
-        }
-      },
-      {
-        $project: {
-          studentId: '$_id',
-          studentName: 1,
-          totalSessions: 1,
-          attendanceRate: {
-            $multiply: [
-              { 
-                $divide: [
-                  { $add: ['$presentSessions', '$lateSessions'] }, 
-                  '$totalSessions'
-                ] 
-              },
-              100
-            ]
-          }
-        }
-      },
-      { $sort: { attendanceRate: -1 } },
-      { $limit: 10 }
-    ]);
+    const student = await User.findById(studentId);
+    if (!student || student.role !== 'student') {
+      return res.status(404).json({
+        success: false,
+        error: 'Student not found'
+      });
+    }
 
-    // Daily trend (last 30 days)
-    const thirtyDaysAgo = new Date();
-    thirtyDaysAgo.setDate(thirtyDaysAgo.getDate() - 30);
+    // Remove student from all courses
+    if (student.enrolledCourses && student.enrolledCourses.length > 0) {
+      await Course.updateMany(
+        { courseCode: { $in: student.enrolledCourses } },
+        { $pull: { enrolledStudents: student.studentId } }
+      );
+    }
 
-    const dailyTrend = await Attendance.aggregate([
-      { 
-        $match: { 
-          timestamp: { $gte: thirtyDaysAgo },
-          ...courseFilter
-        }
-      },
-      {
-        $group: {
-          _id: '$date',
-          totalSessions: { $sum: 1 },
-          presentSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'present'] }, 1, 0] }
-          },
-          lateSessions: {
-            $sum: { $cond: [{ $eq: ['$status', 'late'] }, 1, 0] }
-          }
-        }
-      },
-      { $sort: { _id: 1 } }
-    ]);
+    // Delete all attendance records
+    const removedAttendance = await Attendance.find({ studentId: student.studentId })
+      .select('courseCode timestamp status')
+      .lean();
+    await Attendance.deleteMany({ studentId: student.studentId });
+    await updateAttendanceHeatmap(removedAttendance, -1);
+    await StudentSummary.deleteMany({ studentId: student.studentId });
+
+    // Delete the student
+    await User.findByIdAndDelete(studentId);
+    bumpVersion('students', 'courses', 'attendance', 'streaks', `user:${student.studentId}`, `attendance:${student.studentId}`);
 
     res.json({
       success: true,
-      data: {
-        overview: {
-          totalStudents,
-          totalCourses,
-          totalMaterials,
-          totalAttendanceRecords,
-          presentCount,
-          lateCount,
-          absentCount,
-          overallAttendanceRate: totalAttendanceRecords > 0 
-            ? (((presentCount + lateCount) / totalAttendanceRecords) * 100).toFixed(1) 
-            : '0'
-        },
-        coursePerformance,
-        topStudents,
-        dailyTrend,
-        attendanceBreakdown: {
-          present: presentCount,
-          late: lateCount,
-          absent: absentCount
-        }
-      }
+      message: 'Student deleted successfully'
     });
 
   } catch (error) {
-    console.error('Get analytics error:', error);
+    console.error('Delete student error:', error);
     res.status(500).json({
       success: false,
-      error: 'Failed to fetch analytics data'
+      error: 'Failed to delete student'
+    });
+  }
+});
+
+// Get student courses (for student dashboard)
+app.get('/api/student/courses', authenticateToken, requireStudent, conditionalGet(req => [userScope(req), 'courses']), async (req, res) => {
+  try {
+    const studentId = req.user.studentId;
+    
+    const student = await User.findOne({ 
+      studentId: studentId, 
+      role: 'student',
+      isActive: true 
+    });
+
+    if (!student) {
+      return res.status(404).json({
+        success: false,
+        error: 'Student not found'
+      });
+    }
+
+    const courses = await Course.find({
+      courseCode: { $in: student.enrolledCourses },
+      isActive: true
+    }).select('courseCode courseName instructor schedule');
+
+    res.json({
+      success: true,
+      data: courses
+    });
+
+  } catch (error) {
+    console.error('Get student courses error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to fetch courses'
     });
   }
 });
 
 // Add this endpoint to check if student has registered face
-app.get('/api/student/face/status', authenticateToken, requireStudent, async (req, res) => {
+app.get('/api/student/face/status', authenticateToken, requireStudent, conditionalGet(req => [userScope(req)]), async (req, res) => {
   try {
     const student = await User.findOne({ 
       studentId: req.user.studentId, 
@@ -2203,8 +5350,260 @@ app.get('/api/student/face/status', authenticateToken, requireStudent, async (re
   }
 });
 
+// Web admin console: the `npm run build:web` export, served under /console. Bundles under
+// _expo/static and assets/ carry content hashes and are cached for a year; everything else
+// (index.html) revalidates. Text files get .br/.gz siblings at startup, sent by Accept-Encoding
+const WEB_CONSOLE_DIR = process.env.WEB_CONSOLE_DIR || path.join(__dirname, 'dist-web');
+const WEB_CONSOLE_PATH = '/console';
+const PRECOMPRESSED_EXTENSIONS = new Set(['.js', '.css', '.html', '.json', '.svg', '.map', '.txt']);
+const PRECOMPRESS_MIN_SIZE = 1024;
+const brotliCompressAsync = util.promisify(zlib.brotliCompress);
+const gzipAsync = util.promisify(zlib.gzip);
+
+const WEB_CONSOLE_ENCODINGS = [
+  {
+    encoding: 'br',
+    suffix: '.br',
+    compress: (data) => brotliCompressAsync(data, {
+      params: {
+        [zlib.constants.BROTLI_PARAM_QUALITY]: zlib.constants.BROTLI_MAX_QUALITY,
+        [zlib.constants.BROTLI_PARAM_SIZE_HINT]: data.length
+      }
+    })
+  },
+  { encoding: 'gzip', suffix: '.gz', compress: (data) => gzipAsync(data, { level: 9 }) }
+];
+
+const precompressWebConsole = async (dir = WEB_CONSOLE_DIR) => {
+  let entries;
+  try {
+    entries = await fs.promises.readdir(dir, { withFileTypes: true });
+  } catch (error) {
+    if (error.code === 'ENOENT') return 0;
+    throw error;
+  }
+
+  let written = 0;
+  for (const entry of entries) {
+    const filePath = path.join(dir, entry.name);
+    if (entry.isDirectory()) {
+      written += await precompressWebConsole(filePath);
+      continue;
+    }
+    if (!PRECOMPRESSED_EXTENSIONS.has(path.extname(entry.name))) continue;
+
+    const stats = await fs.promises.stat(filePath);
+    if (stats.size < PRECOMPRESS_MIN_SIZE) continue;
+
+    let data = null;
+    for (const { suffix, compress } of WEB_CONSOLE_ENCODINGS) {
+      const compressedStats = await fs.promises.stat(filePath + suffix).catch(() => null);
+      if (compressedStats && compressedStats.mtimeMs >= stats.mtimeMs) continue;
+      data = data || await fs.promises.readFile(filePath);
+      await fs.promises.writeFile(filePath + suffix, await compress(data));
+      written++;
+    }
+  }
+  return written;
+};
+
+const statFile = (filePath) => fs.promises.stat(filePath).then(stats => (stats.isFile() ? stats : null), () => null);
+
+app.use(WEB_CONSOLE_PATH, async (req, res, next) => {
+  if (req.method !== 'GET' && req.method !== 'HEAD') return next();
+
+  try {
+    const root = path.resolve(WEB_CONSOLE_DIR);
+    let filePath = path.resolve(root, `.${decodeURIComponent(req.path)}`);
+    if (filePath !== root && !filePath.startsWith(root + path.sep)) {
+      return res.status(400).json({ success: false, error: 'Invalid path' });
+    }
+
+    // Client-side routes fall back to the single-page index
+    if (!(await statFile(filePath))) {
+      if (path.extname(filePath)) return next();
+      filePath = path.join(root, 'index.html');
+      if (!(await statFile(filePath))) return next();
+    }
+
+    const relative = path.relative(root, filePath).split(path.sep).join('/');
+    const immutable = relative.startsWith('_expo/static/') || relative.startsWith('assets/');
+    res.set('Cache-Control', immutable ? 'public, max-age=31536000, immutable' : 'no-cache');
+    // The SQLite replica's web worker needs cross-origin isolation
+    res.set('Cross-Origin-Opener-Policy', 'same-origin');
+    res.set('Cross-Origin-Embedder-Policy', 'credentialless');
+
+    let sendPath = filePath;
+    if (PRECOMPRESSED_EXTENSIONS.has(path.extname(filePath))) {
+      res.vary('Accept-Encoding');
+      const accepted = req.acceptsEncodings(WEB_CONSOLE_ENCODINGS.map(({ encoding }) => encoding));
+      const variant = WEB_CONSOLE_ENCODINGS.find(({ encoding }) => encoding === accepted);
+      if (variant && (await statFile(filePath + variant.suffix))) {
+        sendPath = filePath + variant.suffix;
+        res.set('Content-Encoding', variant.encoding);
+        res.type(path.extname(filePath));
+      }
+    }
+
+    res.sendFile(sendPath);
+  } catch (error) {
+    next(error);
+  }
+});
+
+// Request body budgets. Most routes take small JSON; face routes carry one base64 image; upload
+// routes read their bodies with their own parsers (`streamed`), so JSON there keeps the default.
+// A declared Content-Length over budget is refused before any of the body is read, and bodies
+// sent without a length are cut off by the parsers once they pass the same limit.
+const DEFAULT_BODY_LIMIT = 100 * 1024;
+const FACE_IMAGE_BODY_LIMIT = 10 * 1024 * 1024;
+const MULTIPART_OVERHEAD = 1024 * 1024;
+
+const BODY_BUDGETS = [
+  { method: 'POST', path: /^\/api\/(student\/attendance-image|student\/face\/register-image|face\/encode|admin\/students)$/, limit: FACE_IMAGE_BODY_LIMIT, offThread: true },
+  { method: 'POST', path: /^\/api\/(student\/attendance|student\/face\/register)$/, limit: 64 * 1024 },
+  { method: 'POST', path: /^\/api\/telemetry\/perf$/, limit: 256 * 1024 },
+  { method: 'POST', path: /^\/api\/admin\/materials\/(chunks\/missing|[^/]+\/revisions)$/, limit: MANIFEST_BODY_LIMIT },
+  { method: 'POST', path: /^\/api\/admin\/materials$/, limit: MAX_MATERIAL_FILE_SIZE + MULTIPART_OVERHEAD, streamed: true },
+  { method: 'PUT', path: /^\/api\/admin\/materials\/chunks\/[^/]+$/, limit: CDC_CHUNK_BODY_LIMIT, streamed: true },
+  { method: 'PUT', path: /^\/api\/admin\/materials\/uploads\/[^/]+\/chunks\/\d+$/, limit: UPLOAD_CHUNK_BODY_LIMIT, streamed: true }
+];
+
+// Off-thread JSON parsing: face-image bodies are mostly one multi-megabyte base64 string, and
+// parsing them inline stalls every other request. Bodies above JSON_OFF_THREAD_MIN_BYTES on
+// those routes are read as raw bytes (same budget) and parsed by a small worker pool.
+const JSON_OFF_THREAD_MIN_BYTES = parseInt(process.env.JSON_OFF_THREAD_MIN_BYTES, 10) || 256 * 1024;
+const JSON_WORKER_COUNT = Math.max(1, Math.min(2, os.availableParallelism() - 1));
+const JSON_WORKER_SOURCE = `
+const { parentPort } = require('worker_threads');
+parentPort.on('message', ({ id, bytes }) => {
+  try {
+    const body = JSON.parse(Buffer.from(bytes).toString('utf8'));
+    parentPort.postMessage({ id, body });
+  } catch (error) {
+    parentPort.postMessage({ id, error: error.message });
+  }
+});
+`;
+
+const jsonWorkers = [];
+let jsonJobSequence = 0;
+
+const startJsonWorker = () => {
+  const worker = new Worker(JSON_WORKER_SOURCE, { eval: true });
+  const entry = { worker, jobs: new Map() };
+
+  worker.on('message', ({ id, body, error }) => {
+    const job = entry.jobs.get(id);
+    if (!job) return;
+    entry.jobs.delete(id);
+    if (error) {
+      job.reject(Object.assign(new Error(error), { type: 'entity.parse.failed', status: 400 }));
+    } else {
+      job.resolve(body);
+    }
+  });
+  worker.on('error', (error) => {
+    console.error('JSON worker error:', error);
+  });
+  worker.on('exit', () => {
+    entry.jobs.forEach(job => job.reject(new Error('JSON worker exited')));
+    const index = jsonWorkers.indexOf(entry);
+    if (index >= 0) jsonWorkers.splice(index, 1, startJsonWorker());
+  });
+  worker.unref();
+  return entry;
+};
+
+// Hand the bytes to the least busy worker; the buffer is transferred when it owns its memory
+const parseJsonOffThread = (buffer) => {
+  if (jsonWorkers.length === 0) {
+    for (let i = 0; i < JSON_WORKER_COUNT; i++) jsonWorkers.push(startJsonWorker());
+  }
+  const entry = jsonWorkers.reduce((least, candidate) => (candidate.jobs.size < least.jobs.size ? candidate : least));
+
+  const ownsMemory = buffer.byteOffset === 0 && buffer.byteLength === buffer.buffer.byteLength;
+  const bytes = ownsMemory ? new Uint8Array(buffer.buffer) : new Uint8Array(buffer);
+  const id = ++jsonJobSequence;
+
+  return new Promise((resolve, reject) => {
+    entry.jobs.set(id, { resolve, reject });
+    entry.worker.postMessage({ id, bytes }, [bytes.buffer]);
+  });
+};
+
+// One raw parser per limit for the bodies that go to the pool
+const rawJsonParsers = new Map();
+const rawJsonParserFor = (limit) => {
+  if (!rawJsonParsers.has(limit)) {
+    rawJsonParsers.set(limit, express.raw({ type: 'application/json', limit }));
+  }
+  return rawJsonParsers.get(limit);
+};
+
+const parseJsonBodyOffThread = (req, res, limit, next) => {
+  rawJsonParserFor(limit)(req, res, (error) => {
+    if (error) return next(error);
+    if (!Buffer.isBuffer(req.body)) return next();
+    if (req.body.length === 0) {
+      req.body = {};
+      return next();
+    }
+    parseJsonOffThread(req.body)
+      .then((body) => {
+        req.body = body;
+        next();
+      })
+      .catch(next);
+  });
+};
+
+// One json/urlencoded parser pair per distinct limit
+const bodyParsers = new Map();
+const bodyParsersFor = (limit) => {
+  if (!bodyParsers.has(limit)) {
+    bodyParsers.set(limit, [express.json({ limit }), express.urlencoded({ extended: true, limit })]);
+  }
+  return bodyParsers.get(limit);
+};
+
+const parseBodyWithinBudget = (req, res, next) => {
+  const budget = BODY_BUDGETS.find(entry => entry.method === req.method && entry.path.test(req.path));
+  const limit = budget ? budget.limit : DEFAULT_BODY_LIMIT;
+
+  if (Number(req.headers['content-length']) > limit) {
+    res.set('Connection', 'close');
+    return res.status(413).json({
+      success: false,
+      error: `Request body too large (limit ${limit} bytes)`
+    });
+  }
+
+  const declaredLength = req.headers['content-length'] === undefined ? Infinity : Number(req.headers['content-length']);
+  if (budget?.offThread && req.is('application/json') && declaredLength >= JSON_OFF_THREAD_MIN_BYTES) {
+    return parseJsonBodyOffThread(req, res, limit, next);
+  }
+
+  const [json, urlencoded] = bodyParsersFor(budget && !budget.streamed ? limit : DEFAULT_BODY_LIMIT);
+  json(req, res, (error) => (error ? next(error) : urlencoded(req, res, next)));
+};
+
 // Error handling middleware
 app.use((error, req, res, next) => {
+  if (error.type === 'entity.too.large') {
+    res.set('Connection', 'close');
+    return res.status(413).json({
+      success: false,
+      error: `Request body too large (limit ${error.limit} bytes)`
+    });
+  }
+  if (error.type === 'entity.parse.failed') {
+    return res.status(400).json({
+      success: false,
+      error: 'Malformed request body'
+    });
+  }
+
   console.error('Unhandled error:', error);
   
   if (error instanceof multer.MulterError) {
@@ -2335,9 +5734,196 @@ const initializeDefaultData = async () => {
   }
 };
 
+// Build the heatmap cube from existing attendance (one pass, only when the cube is empty)
+const initializeAttendanceHeatmap = async () => {
+  try {
+    const existingCells = await AttendanceHeatmap.estimatedDocumentCount();
+    if (existingCells > 0) {
+      return;
+    }
+
+    const cellMap = new Map();
+    const cursor = Attendance.find({}).select('courseCode timestamp status').lean().cursor();
+    for await (const record of cursor) {
+      if (!['present', 'late', 'absent', 'excused'].includes(record.status)) continue;
+      const cell = heatmapCellFor(record);
+      const key = `${cell.courseCode}|${cell.weekday}|${cell.hour}`;
+      if (!cellMap.has(key)) {
+        cellMap.set(key, { ...cell, present: 0, late: 0, absent: 0, excused: 0 });
+      }
+      cellMap.get(key)[record.status]++;
+    }
+
+    // Roster absences recorded at session close-out
+    const closeOuts = await SessionCloseOut.find({ absentees: { $gt: 0 }, weekday: { $ne: null } }).lean();
+    closeOuts.forEach(({ courseCode, weekday, hour, absentees }) => {
+      const key = `${courseCode}|${weekday}|${hour}`;
+      if (!cellMap.has(key)) {
+        cellMap.set(key, { courseCode, weekday, hour, present: 0, late: 0, absent: 0, excused: 0 });
+      }
+      cellMap.get(key).absent += absentees;
+    });
+
+    if (cellMap.size > 0) {
+      await AttendanceHeatmap.insertMany([...cellMap.values()], { ordered: false });
+      console.log(`✅ Built attendance heatmap (${cellMap.size} cells)`);
+    }
+  } catch (error) {
+    console.error('❌ Error building attendance heatmap:', error.message);
+  }
+};
+
+// Build the lateness digests from existing late records (only when no digest exists yet)
+const initializeLatenessDigests = async () => {
+  try {
+    const existingDigests = await LatenessDigest.estimatedDocumentCount();
+    if (existingDigests > 0) {
+      return;
+    }
+
+    const digestMap = new Map();
+    const cursor = Attendance.find({ isLate: true, lateMinutes: { $gt: 0 } })
+      .select('courseCode date lateMinutes')
+      .lean()
+      .cursor();
+    for await (const record of cursor) {
+      const key = `${record.courseCode}|${record.date}`;
+      if (!digestMap.has(key)) {
+        digestMap.set(key, { courseCode: record.courseCode, date: record.date, digest: new TDigest(LATENESS_DIGEST_COMPRESSION), sum: 0 });
+      }
+      const entry = digestMap.get(key);
+      entry.digest.add(record.lateMinutes);
+      entry.sum += record.lateMinutes;
+    }
+
+    const docs = [...digestMap.values()].map(({ courseCode, date, digest, sum }) => {
+      digest.compress();
+      return { courseCode, date, centroids: digest.centroids, count: digest.count, sum, min: digest.min, max: digest.max, unmerged: 0 };
+    });
+    if (docs.length > 0) {
+      await LatenessDigest.insertMany(docs, { ordered: false });
+      console.log(`✅ Built lateness digests (${docs.length} course-days)`);
+    }
+  } catch (error) {
+    console.error('❌ Error building lateness digests:', error.message);
+  }
+};
+
+// Backfill streaks on first start; past sessions are then closed out by closeOutPreviousSessions
+const initializeAttendanceStreaks = async () => {
+  try {
+    const existingSummaries = await StudentSummary.estimatedDocumentCount();
+    if (existingSummaries === 0) {
+      const results = await backfillAttendanceStreaks();
+      if (results.length > 0) {
+        console.log(`✅ Backfilled attendance streaks (${results.length} courses)`);
+      }
+    }
+  } catch (error) {
+    console.error('❌ Error backfilling attendance streaks:', error.message);
+  }
+};
+
+// Every past session in the look-back window that has attendance but no close-out yet is closed,
+// oldest first, so days missed while the server was down are still processed
+const CLOSE_OUT_LOOKBACK_DAYS = 30;
+const closeOutPreviousSessions = async () => {
+  try {
+    const today = new Date().toISOString().split('T')[0];
+    const since = new Date(Date.now() - CLOSE_OUT_LOOKBACK_DAYS * 24 * 60 * 60 * 1000).toISOString().split('T')[0];
+    const pastDates = { $gte: since, $lt: today };
+    const courseCodes = await Attendance.distinct('courseCode', { date: pastDates });
+    for (const courseCode of courseCodes) {
+      const [dates, closedDates] = await Promise.all([
+        Attendance.distinct('date', { courseCode, date: pastDates }),
+        SessionCloseOut.distinct('date', { courseCode, date: pastDates })
+      ]);
+      const closed = new Set(closedDates);
+      for (const date of dates.sort()) {
+        if (!closed.has(date)) {
+          await closeOutCourseSession(courseCode, date);
+        }
+      }
+    }
+  } catch (error) {
+    console.error('Error closing out sessions:', error);
+  }
+};
+
+// Re-arm the publish-time version bumps for materials scheduled in the future
+const initializeMaterialPublishBumps = async () => {
+  try {
+    const upcoming = await Material.find({ isActive: true, publishDate: { $gt: new Date() } })
+      .select('courseCode publishDate')
+      .lean();
+    upcoming.forEach(material => scheduleMaterialPublishBump(material.courseCode, material.publishDate));
+  } catch (error) {
+    console.error('❌ Error scheduling material publish bumps:', error.message);
+  }
+};
+
+// Build the material search index in the background and keep it compacted
+const initializeMaterialSearch = async () => {
+  try {
+    const materials = await Material.find({ isActive: true }).select('+manifest').lean();
+    materials.forEach(material => materialSearchIndex.add(material));
+    materialSearchIndex.compact();
+    console.log(`✅ Indexed ${materials.length} materials for search`);
+
+    setInterval(() => materialSearchIndex.compact(), SEARCH_COMPACTION_INTERVAL_MS).unref();
+
+    for (const material of materials) {
+      if (hasMaterialFile(material)) {
+        await indexMaterial(material);
+      }
+    }
+  } catch (error) {
+    console.error('❌ Error building material search index:', error.message);
+  }
+};
+
+// Hash profile images stored before image URLs were versioned
+const initializeProfileImageHashes = async () => {
+  try {
+    const cursor = User.find({ profileImage: { $nin: [null, ''] }, profileImageHash: { $exists: false } })
+      .select('profileImage')
+      .lean()
+      .cursor();
+    let updated = 0;
+    for await (const user of cursor) {
+      const profileImageHash = crypto.createHash('sha1').update(user.profileImage).digest('hex').slice(0, 16);
+      await User.updateOne({ _id: user._id }, { $set: { profileImageHash } });
+      updated++;
+    }
+    if (updated > 0) {
+      console.log(`✅ Versioned ${updated} profile images`);
+    }
+  } catch (error) {
+    console.error('❌ Error versioning profile images:', error.message);
+  }
+};
+
+// Requeue video transcodes interrupted by a restart
+const initializeVideoTranscodes = async () => {
+  try {
+    const materials = await Material.find({
+      materialType: 'video',
+      isActive: true,
+      'streaming.status': { $in: ['pending', 'processing'] }
+    }).select('_id').lean();
+    materials.forEach(material => queueVideoTranscode(material._id));
+    if (materials.length > 0) {
+      console.log(`🎬 Queued ${materials.length} video transcodes`);
+    }
+  } catch (error) {
+    console.error('❌ Error queueing video transcodes:', error.message);
+  }
+};
+
 // Start server
 const startServer = async () => {
   try {
+    connectToDatabase();
     await new Promise((resolve, reject) => {
       mongoose.connection.once('open', resolve);
       mongoose.connection.once('error', reject);
@@ -2348,11 +5934,28 @@ const startServer = async () => {
     console.log(`   📍 Database: ${MONGODB_URI}`);
     
     await initializeDefaultData();
-    
+    await initializeAttendanceHeatmap();
+    await initializeLatenessDigests();
+    await initializeAttendanceStreaks();
+    await initializeMaterialPublishBumps();
+    initializeMaterialSearch();
+    await closeOutPreviousSessions();
+    setInterval(traceJob('sessions.closeOut', closeOutPreviousSessions), 15 * 60 * 1000).unref();
+    await cleanupStaleUploads();
+    setInterval(traceJob('uploads.cleanup', cleanupStaleUploads), 60 * 60 * 1000).unref();
+    await initializeVideoTranscodes();
+    await initializeProfileImageHashes();
+    setInterval(traceJob('chunks.sweep', sweepUnreferencedChunks), 6 * 60 * 60 * 1000).unref();
+    const precompressed = await precompressWebConsole();
+    if (precompressed > 0) {
+      console.log(`🗜️ Precompressed ${precompressed} web console files`);
+    }
+
     app.listen(PORT, '0.0.0.0', () => {
       console.log('\n🚀 Professional Attendance System Server Started!');
       console.log(`   🌐 Server: http://localhost:${PORT}`);
       console.log(`   🏥 Health: http://localhost:${PORT}/api/health`);
+      console.log(`   🖥️ Admin console: http://localhost:${PORT}${WEB_CONSOLE_PATH}`);
       console.log(`   📱 Mobile: http://192.168.1.2:${PORT}/api`);
       console.log('\n📋 Default Login Credentials:');
       console.log('   👤 Admin - ID: admin001, Password: admin123');
@@ -2371,18 +5974,35 @@ const startServer = async () => {
   }
 };
 
-// Graceful shutdown
-process.on('SIGINT', async () => {
-  console.log('\n🛑 Shutting down server gracefully...');
-  
-  try {
-    await mongoose.connection.close();
-    console.log('✅ MongoDB connection closed');
-    process.exit(0);
-  } catch (error) {
-    console.error('❌ Error during shutdown:', error);
-    process.exit(1);
-  }
-});
+// Run as `node server.js`; tests and benchmarks require the module without starting it
+if (require.main === module) {
+  // Graceful shutdown
+  process.on('SIGINT', async () => {
+    console.log('\n🛑 Shutting down server gracefully...');
+    
+    try {
+      await mongoose.connection.close();
+      console.log('✅ MongoDB connection closed');
+      process.exit(0);
+    } catch (error) {
+      console.error('❌ Error during shutdown:', error);
+      process.exit(1);
+    }
+  });
+
+  startServer();
+}
 
-startServer();
\ No newline at end of file
+module.exports = {
+  app,
+  startServer,
+  TDigest,
+  LATENESS_DIGEST_COMPRESSION,
+  LATENESS_DIGEST_MAX_UNMERGED,
+  cdcChunks,
+  decodeImagePayload,
+  bodyValidators,
+  shedUnderOverload,
+  Attendance,
+  shapeAttendanceDocument
+};
\ No newline at end of file